@@ -0,0 +1,98 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include "externals.h"
+
+/* The size of a regular chunk of memory allocated by an arena. */
+#define ARENA_CHUNK_SIZE (16 * 1024)
+
+/* The alignment of all allocations made from an arena. */
+#define ARENA_ALIGNMENT (2 * sizeof(void *))
+
+/** A chunk of memory from which the allocations of an arena are served. */
+typedef struct xcb_xrm_arena_chunk_t {
+    /* The next (older) chunk of the arena. */
+    struct xcb_xrm_arena_chunk_t *next;
+    /* The number of usable bytes in this chunk. */
+    size_t size;
+    /* The number of bytes of this chunk which have been handed out. */
+    size_t used;
+} xcb_xrm_arena_chunk_t;
+
+/**
+ * A bump allocator. Memory is handed out sequentially from large chunks and
+ * can only be released all at once by freeing the arena, which makes
+ * allocations cheap and freeing proportional to the number of chunks. The
+ * only exception is the most recent allocation, which can be undone.
+ *
+ * An arena must be initialized to all zeros before it is used.
+ */
+typedef struct xcb_xrm_arena_t {
+    /* The chunks of this arena, starting with the one currently used. */
+    xcb_xrm_arena_chunk_t *chunks;
+} xcb_xrm_arena_t;
+
+/**
+ * Allocates zero-initialized memory of the given size from the arena. If
+ * arena is NULL, the memory is allocated with calloc() instead and must be
+ * freed by the caller.
+ *
+ * @return The allocated memory or NULL on failure.
+ *
+ */
+void *__xcb_xrm_arena_alloc(xcb_xrm_arena_t *arena, size_t size);
+
+/**
+ * Copies the first length bytes of the given string into memory allocated
+ * from the arena and NUL-terminates it. If arena is NULL, the memory is
+ * allocated from the heap as in __xcb_xrm_arena_alloc.
+ *
+ */
+char *__xcb_xrm_arena_strndup(xcb_xrm_arena_t *arena, const char *str, size_t length);
+
+/**
+ * Returns memory of the given size to the arena if it is the most recent
+ * allocation made from it, so that it is handed out again. Otherwise, the
+ * memory stays in use until the arena is freed.
+ *
+ * @return True if the memory was returned to the arena.
+ *
+ */
+bool __xcb_xrm_arena_release(xcb_xrm_arena_t *arena, void *ptr, size_t size);
+
+/**
+ * Releases all memory allocated from the arena. The arena can be used again
+ * afterwards.
+ *
+ */
+void __xcb_xrm_arena_free(xcb_xrm_arena_t *arena);
+
+#endif /* __ARENA_H__ */
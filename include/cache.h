@@ -0,0 +1,114 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include "externals.h"
+
+#include "quark.h"
+
+struct xcb_xrm_query_t;
+
+/* Number of slots in a lookup cache. Must be a power of two. */
+#define CACHE_SIZE 256
+
+/* The maximum number of components of a query whose result is cached. */
+#define CACHE_MAX_COMPONENTS 8
+
+/** A single cached lookup result. */
+typedef struct xcb_xrm_cache_slot_t {
+    /* Odd while the slot is being written. Readers which observe it changing
+     * discard what they have read. */
+    uint32_t sequence;
+    /* The database generation this result was computed for. 0 if the slot is
+     * unused. */
+    uint32_t generation;
+    /* Hash of the key. */
+    uint32_t hash;
+    /* The number of components of the query. */
+    int length;
+    /* The value of the matching entry or NULL if the query did not match. */
+    const char *value;
+    /* The name and class of every component of the query, alternating. */
+    xcb_xrm_quark_t key[2 * CACHE_MAX_COMPONENTS];
+} xcb_xrm_cache_slot_t;
+
+/**
+ * Direct-mapped cache of lookup results. A result is only valid for the
+ * database generation it was computed for, so modifying the database
+ * invalidates all results at once.
+ *
+ * Lookups store their results, so concurrent lookups on the same database
+ * write to the cache. Each slot is guarded by a sequence counter instead of a
+ * lock: a store into a slot that is already being written is dropped, and a
+ * lookup that races with a store is treated as a miss.
+ */
+typedef struct xcb_xrm_cache_t {
+    xcb_xrm_cache_slot_t slots[CACHE_SIZE];
+} xcb_xrm_cache_t;
+
+/**
+ * Creates a new, empty cache.
+ *
+ */
+xcb_xrm_cache_t *__xcb_xrm_cache_new(void);
+
+/**
+ * Looks up the result of the query for the given database generation.
+ *
+ * @param value Out parameter to which the cached value (or NULL for a cached
+ * mismatch) will be written.
+ * @return True if the result was cached.
+ *
+ */
+bool __xcb_xrm_cache_find(xcb_xrm_cache_t *cache, uint32_t generation, struct xcb_xrm_query_t *query,
+        const char **value);
+
+/**
+ * Stores the result of the query for the given database generation, replacing
+ * whatever was cached in the same slot. Queries with more than
+ * CACHE_MAX_COMPONENTS components are not cached.
+ *
+ */
+void __xcb_xrm_cache_store(xcb_xrm_cache_t *cache, uint32_t generation, struct xcb_xrm_query_t *query,
+        const char *value);
+
+/**
+ * Drops all cached results.
+ *
+ */
+void __xcb_xrm_cache_clear(xcb_xrm_cache_t *cache);
+
+/**
+ * Destroys the given cache.
+ *
+ */
+void __xcb_xrm_cache_free(xcb_xrm_cache_t *cache);
+
+#endif /* __CACHE_H__ */
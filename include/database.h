@@ -32,8 +32,95 @@
 #include "externals.h"
 
 #include "xcb_xrm.h"
+#include "arena.h"
+#include "cache.h"
 #include "entry.h"
+#include "node.h"
 
-TAILQ_HEAD(xcb_xrm_database_t, xcb_xrm_entry_t);
+/* Initial number of buckets in the specifier index. Must be a power of two. */
+#define INDEX_INITIAL_SIZE 64
+
+/* Initial number of bits in the filter over final component names. Must be a
+ * power of two. */
+#define FILTER_INITIAL_BITS 4096
+
+/* The filter is doubled before it has fewer bits than this per final name,
+ * which keeps its false positive rate at about 5%. */
+#define FILTER_BITS_PER_NAME 8
+
+/* The two bits of a filter of 2^(64 - shift) bits which represent the given
+ * component name. Both are taken from the upper bits of a multiplicative hash
+ * since its low bits are only a permutation of the low bits of the name. */
+#define FILTER_BIT_FIRST(name, shift) (((uint64_t)(name) * UINT64_C(0x9e3779b97f4a7c15)) >> (shift))
+#define FILTER_BIT_SECOND(name, shift) (((uint64_t)(name) * UINT64_C(0xc2b2ae3d27d4eb4f)) >> (shift))
+
+struct xcb_xrm_query_t;
+
+struct xcb_xrm_database_t {
+    /* The arena from which all entries and nodes of this database are
+     * allocated. An entry replaced by a value which does not fit into its
+     * memory is not released before the database is freed. */
+    xcb_xrm_arena_t arena;
+
+    /* All entries of this database in insertion order. */
+    TAILQ_HEAD(entries_head, xcb_xrm_entry_t) entries;
+
+    /* Hash index over the specifiers of all entries, used to find duplicate
+     * entries in constant time. The buckets are chained through
+     * xcb_xrm_entry_t.index_next. */
+    xcb_xrm_entry_t **index;
+    /* The number of buckets in the index. */
+    size_t index_size;
+    /* The number of entries in the database. */
+    size_t num_entries;
+
+    /* Root of the component tree which is used for matching queries. */
+    xcb_xrm_node_t *root;
+
+    /* Bloom filter over the last component names of all entries. Since the
+     * last component of an entry is never a wildcard, a query can only match
+     * if its final name or class is in the filter. */
+    uint64_t *filter;
+    /* The filter has 2^(64 - filter_shift) bits. */
+    int filter_shift;
+    /* The number of names which were added to the filter while it did not
+     * contain them yet. */
+    size_t filter_names;
+
+    /* Incremented whenever the database is modified. */
+    uint32_t generation;
+    /* Cache of lookup results or NULL if caching is disabled. */
+    xcb_xrm_cache_t *cache;
+};
+
+/**
+ * Returns false if no entry of the database ends with the given component
+ * name. Otherwise, one may or may not.
+ *
+ */
+static inline bool __xcb_xrm_database_filter_contains(xcb_xrm_database_t *database, xcb_xrm_quark_t name) {
+    uint64_t first = FILTER_BIT_FIRST(name, database->filter_shift);
+    uint64_t second = FILTER_BIT_SECOND(name, database->filter_shift);
+
+    return (database->filter[first / 64] & ((uint64_t)1 << (first % 64))) &&
+        (database->filter[second / 64] & ((uint64_t)1 << (second % 64)));
+}
+
+/**
+ * Returns false if no entry of the database can match the query since neither
+ * the final name nor the final class of the query ends any entry. Otherwise,
+ * the query may or may not match.
+ *
+ */
+bool __xcb_xrm_database_filter_test(xcb_xrm_database_t *database, struct xcb_xrm_query_t *query);
+
+/**
+ * Returns the entry whose specifier is the query's resource name with only
+ * tight bindings or NULL if there is none. Such an entry matches every
+ * component by name through a tight binding, so it takes precedence over any
+ * other entry matching the query.
+ *
+ */
+xcb_xrm_entry_t *__xcb_xrm_database_find_exact(xcb_xrm_database_t *database, struct xcb_xrm_query_t *query);
 
 #endif /* __DATABASE_H__ */
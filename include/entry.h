@@ -29,16 +29,17 @@
 #ifndef __ENTRY_H__
 #define __ENTRY_H__
 
+#include "arena.h"
+#include "quark.h"
+
 /** Defines where the parser is currently at. */
 typedef enum {
     /* Reading initial workspace before anything else. */
     CS_INITIAL = 0,
     /* Reading the resource path. */
     CS_COMPONENTS = 1,
-    /* Reading whitespace between ':' and the value. */
-    CS_PRE_VALUE_WHITESPACE = 2,
-    /* Reading the resource's value. */
-    CS_VALUE = 3
+    /* Reached the ':' which separates the resource path from the value. */
+    CS_PRE_VALUE_WHITESPACE = 2
 } xcb_xrm_entry_parser_chunk_status_t;
 
 /** Specifies the type of a component. */
@@ -55,24 +56,39 @@ typedef enum {
     BT_LOOSE = 1
 } xcb_xrm_binding_type_t;
 
+/** Number of components the parser can collect without allocating. */
+#define PARSER_INLINE_COMPONENTS 16
+
 /** One component of a resource, either in the name or class. */
 typedef struct xcb_xrm_component_t {
-    /* The type of this component. */
-    xcb_xrm_component_type_t type;
-    /* The binding type of this component. */
-    xcb_xrm_binding_type_t binding_type;
     /* This component's name. Only useful if the type is CT_NORMAL. */
-    char *name;
-
-    TAILQ_ENTRY(xcb_xrm_component_t) components;
+    xcb_xrm_quark_t name;
+    /* The type of this component, see xcb_xrm_component_type_t. */
+    uint8_t type;
+    /* The binding type of this component, see xcb_xrm_binding_type_t. */
+    uint8_t binding_type;
 } xcb_xrm_component_t;
 
 /** Used in xcb_xrm_entry_parse. */
 typedef struct xcb_xrm_entry_parser_state_t {
     xcb_xrm_entry_parser_chunk_status_t chunk;
-    char *buffer;
-    char *buffer_pos;
     xcb_xrm_binding_type_t current_binding_type;
+
+    /* The name of the component currently being parsed. It points into the
+     * parsed string unless line continuations split the name, in which case
+     * its pieces are joined in buffer. */
+    const char *name;
+    size_t name_length;
+    /* Scratch space for joining names, reused for every component. */
+    char *buffer;
+    size_t buffer_size;
+
+    /* The components parsed so far. This points to inline_components until
+     * more than PARSER_INLINE_COMPONENTS components are needed. */
+    xcb_xrm_component_t *components;
+    int num_components;
+    int components_size;
+    xcb_xrm_component_t inline_components[PARSER_INLINE_COMPONENTS];
 } xcb_xrm_entry_parser_state_t;
 
 /**
@@ -81,34 +97,48 @@ typedef struct xcb_xrm_entry_parser_state_t {
  *     Application*class?subclass.resource.
  */
 typedef struct xcb_xrm_entry_t {
-    /* The value of this entry. */
+    /* The value of this entry. Stored in the same allocation as the entry. */
     char *value;
 
-    /* The individual components making up this entry. */
-    TAILQ_HEAD(components_head, xcb_xrm_component_t) components;
+    /* Hash of the specifier, see __xcb_xrm_entry_hash. Only valid while the
+     * entry is stored in a database or is the name of a query. */
+    uint32_t hash;
+    /* Next entry in the same bucket of the database's specifier index. */
+    struct xcb_xrm_entry_t *index_next;
 
     TAILQ_ENTRY(xcb_xrm_entry_t) entries;
+
+    /* The number of components making up this entry. */
+    int num_components;
+    /* The individual components making up this entry. */
+    xcb_xrm_component_t components[];
 } xcb_xrm_entry_t;
 
 /**
  * Parses a specific resource string.
  *
  * @param str The resource string.
- * @param entry A return struct that will contain the parsed resource. The
- * memory will be allocated dynamically, so it must be freed.
+ * @param entry A return struct that will contain the parsed resource.
  * @param resource_only If true, no wildcards are allowed and only a resource
  * name is parsed.
+ * @param arena The arena to allocate the entry from. If NULL, the entry is
+ * allocated dynamically and must be freed using xcb_xrm_entry_free.
  *
  * @return 0 on success, a negative error code otherwise.
  *
  */
-int xcb_xrm_entry_parse(const char *str, xcb_xrm_entry_t **entry, bool resource_only);
+int xcb_xrm_entry_parse(const char *str, xcb_xrm_entry_t **entry, bool resource_only, xcb_xrm_arena_t *arena);
 
 /**
- * Returns the number of components of the given entry.
+ * Parses a resource string of the given length which does not need to be
+ * NUL-terminated. If continuations is set, any backslash followed by a newline
+ * is ignored as a line continuation.
+ *
+ * @return 0 on success, a negative error code otherwise.
  *
  */
-int __xcb_xrm_entry_num_components(xcb_xrm_entry_t *entry);
+int __xcb_xrm_entry_parse_buffer(const char *str, size_t length, bool continuations, xcb_xrm_entry_t **entry,
+        bool resource_only, xcb_xrm_arena_t *arena);
 
 /**
  * Compares the two entries.
@@ -117,6 +147,14 @@ int __xcb_xrm_entry_num_components(xcb_xrm_entry_t *entry);
  */
 int __xcb_xrm_entry_compare(xcb_xrm_entry_t *first, xcb_xrm_entry_t *second);
 
+/**
+ * Returns a hash of the entry's specifier, i.e., of its components' types,
+ * binding types and names. Entries which compare equal using
+ * __xcb_xrm_entry_compare have the same hash.
+ *
+ */
+uint32_t __xcb_xrm_entry_hash(xcb_xrm_entry_t *entry);
+
 /**
  * Returns a string representation of this entry.
  *
@@ -124,10 +162,22 @@ int __xcb_xrm_entry_compare(xcb_xrm_entry_t *first, xcb_xrm_entry_t *second);
 char *__xcb_xrm_entry_to_string(xcb_xrm_entry_t *entry);
 
 /**
- * Copy the entry.
+ * Copy the entry into memory allocated from the given arena. If arena is NULL,
+ * the copy must be freed using xcb_xrm_entry_free.
+ *
+ */
+xcb_xrm_entry_t *__xcb_xrm_entry_copy(xcb_xrm_entry_t *entry, xcb_xrm_arena_t *arena);
+
+/**
+ * Replaces the value of current with the value of entry, which must have the
+ * same specifier, if it fits into the memory of current. The memory of entry
+ * is returned to the arena if possible.
+ *
+ * @return True if the value was replaced, in which case entry must not be
+ * used anymore.
  *
  */
-xcb_xrm_entry_t *__xcb_xrm_entry_copy(xcb_xrm_entry_t *entry);
+bool __xcb_xrm_entry_replace_value(xcb_xrm_entry_t *current, xcb_xrm_entry_t *entry, xcb_xrm_arena_t *arena);
 
 /**
  * Escapes magic values.
@@ -136,7 +186,8 @@ xcb_xrm_entry_t *__xcb_xrm_entry_copy(xcb_xrm_entry_t *entry);
 char *__xcb_xrm_entry_escape_value(const char *value);
 
 /**
- * Frees the given entry.
+ * Frees the given entry. Must not be used for entries allocated from an
+ * arena.
  *
  * @param entry The entry to be freed.
  *
@@ -35,6 +35,7 @@
 #include <stddef.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <libgen.h>
 #include <ctype.h>
@@ -43,6 +44,7 @@
 #include <math.h>
 #include <assert.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <sys/queue.h>
 #include <sys/stat.h>
 
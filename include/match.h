@@ -32,44 +32,45 @@
 #include "database.h"
 #include "resource.h"
 #include "entry.h"
+#include "node.h"
 
-/** Information about a matched component. */
-typedef enum xcb_xrm_match_flags_t {
-    MF_NONE = 1 << 0,
+/* Number of query components a lookup can handle using stack memory only.
+ * Longer queries fall back to allocating their scratch space. */
+#define MATCH_INLINE_LENGTH 32
 
-    /* The component was matched on the name. */
-    MF_NAME = 1 << 1,
-    /* The component was matched on the class. */
-    MF_CLASS = 1 << 2,
-    /* The component was matched via a '?' wildcard. */
-    MF_WILDCARD = 1 << 3,
-    /* The component was matched as part of a loose binding. */
-    MF_SKIPPED = 1 << 4,
+/* Number of slots of the table of visited states a lookup keeps on the stack.
+ * Must be a power of two. The number of states is only bounded by the number
+ * of nodes times the query length, so a lookup visiting more than half as many
+ * states moves the table to the heap. */
+#define MATCH_INLINE_STATES 64
 
-    /* This component was preceded by a loose binding. */
-    MF_PRECEDING_LOOSE = 1 << 5,
-} xcb_xrm_match_flags_t;
+/** A node of the component tree reached at a given query position. */
+typedef struct xcb_xrm_match_state_t {
+    /* The node or NULL if this slot of the state table is unused. */
+    xcb_xrm_node_t *node;
+    /* The query position at which the node was reached. */
+    int position;
+    /* Set if the node was reached by skipping the previous component. */
+    bool loose_only;
+} xcb_xrm_match_state_t;
 
-/**
- * Helper enum to decide whether a component in a loose binding shall be
- * skipped even if it matches.
- */
-typedef enum xcb_xrm_match_ignore_t {
-    MI_UNDECIDED,
-    MI_IGNORE,
-    MI_DO_NOT_IGNORE,
-} xcb_xrm_match_ignore_t;
-
-typedef struct xcb_xrm_match_t {
-    /* Reference to the database entry this match refers to. */
-	xcb_xrm_entry_t *entry;
-    /* An array where the n-th element describes how the n-th element of the
-     * query strings was matched. */
-	xcb_xrm_match_flags_t *flags;
-} xcb_xrm_match_t;
+/** One step of the walk through the component tree. */
+typedef struct xcb_xrm_match_frame_t {
+    /* The node reached by the query components before this frame's
+     * position. */
+    xcb_xrm_node_t *node;
+    /* Set if the previous query component was skipped by a loose binding, so
+     * only loose children may match the component at this position. */
+    bool loose_only;
+    /* The next way of matching the component at this position to try. */
+    int step;
+} xcb_xrm_match_frame_t;
 
 /**
  * Finds the matching entry in the database given a full name / class query string.
+ * The value of the entry is stored in the resource, or NULL if no entry matches.
+ *
+ * @return 0 on success, a negative error code otherwise.
  *
  */
 int __xcb_xrm_match(xcb_xrm_database_t *database, xcb_xrm_entry_t *query_name, xcb_xrm_entry_t *query_class,
@@ -0,0 +1,114 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#ifndef __NODE_H__
+#define __NODE_H__
+
+#include "externals.h"
+
+#include "arena.h"
+#include "entry.h"
+#include "quark.h"
+
+/* Initial number of buckets in a node's child table. Must be a power of two. */
+#define NODE_TABLE_INITIAL_SIZE 4
+
+struct xcb_xrm_node_t;
+
+/** Hash table mapping component names to child nodes. */
+typedef struct xcb_xrm_node_table_t {
+    /* The buckets, chained through xcb_xrm_node_t.next. */
+    struct xcb_xrm_node_t **buckets;
+    /* The number of buckets. */
+    size_t size;
+    /* The number of nodes in the table. */
+    size_t count;
+} xcb_xrm_node_table_t;
+
+/**
+ * A node in the component tree of a database. Nodes are allocated from the
+ * database's arena and released along with it.
+ *
+ * Every entry of the database is stored in the node reached by following its
+ * components from the root node. The children of a node are kept in separate
+ * tables depending on the binding type and whether the component is a '?'
+ * wildcard, so that a lookup only needs to visit the branches which can
+ * actually match the queried component.
+ */
+typedef struct xcb_xrm_node_t {
+    /* The name of the component leading to this node. NULLQUARK for the root
+     * node and for '?' components. */
+    xcb_xrm_quark_t name;
+    /* Next node in the same bucket of the parent's child table. */
+    struct xcb_xrm_node_t *next;
+
+    /* The entry whose last component leads to this node, if any. The entry
+     * is owned by the database. */
+    xcb_xrm_entry_t *entry;
+
+    /* Children reached through a tight binding ('.'). */
+    xcb_xrm_node_table_t tight;
+    /* Children reached through a loose binding ('*'). */
+    xcb_xrm_node_table_t loose;
+    /* Child for a '?' component reached through a tight binding. */
+    struct xcb_xrm_node_t *tight_wildcard;
+    /* Child for a '?' component reached through a loose binding. */
+    struct xcb_xrm_node_t *loose_wildcard;
+} xcb_xrm_node_t;
+
+/**
+ * Creates a new, empty root node allocated from the given arena.
+ *
+ */
+xcb_xrm_node_t *__xcb_xrm_node_new(xcb_xrm_arena_t *arena);
+
+/**
+ * Stores the entry in the node described by its components, creating any
+ * missing nodes along the way from the given arena. An entry previously stored
+ * in the same node is replaced.
+ *
+ * @return 0 on success, a negative error code otherwise.
+ *
+ */
+int __xcb_xrm_node_insert(xcb_xrm_node_t *root, xcb_xrm_entry_t *entry, xcb_xrm_arena_t *arena);
+
+/**
+ * Returns the child of the node reached through the given binding type and
+ * component name or NULL if there is no such child.
+ *
+ */
+xcb_xrm_node_t *__xcb_xrm_node_find_child(xcb_xrm_node_t *node, xcb_xrm_binding_type_t binding_type,
+        xcb_xrm_quark_t name);
+
+/**
+ * Returns true if the node has any children reached through a loose binding.
+ *
+ */
+bool __xcb_xrm_node_has_loose_children(xcb_xrm_node_t *node);
+
+#endif /* __NODE_H__ */
@@ -0,0 +1,97 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#ifndef __QUARK_H__
+#define __QUARK_H__
+
+#include "externals.h"
+
+/* Initial number of slots in the quark table. Must be a power of two. */
+#define QUARK_TABLE_INITIAL_SIZE 256
+
+/**
+ * Identifier for an interned string. Two strings are equal if and only if
+ * their quarks are equal, so that component names can be compared as
+ * integers. Quarks are shared by all databases and stay valid for the lifetime
+ * of the process.
+ */
+typedef uint32_t xcb_xrm_quark_t;
+
+/* The quark which does not represent any string. */
+#define NULLQUARK ((xcb_xrm_quark_t) 0)
+
+/** An interned string. Entries are never modified once they are published. */
+typedef struct xcb_xrm_quark_entry_t {
+    /* The hash of the string. */
+    uint32_t hash;
+    /* The quark representing the string. */
+    xcb_xrm_quark_t quark;
+    /* The NUL-terminated string. */
+    char str[];
+} xcb_xrm_quark_entry_t;
+
+/**
+ * Open addressing hash table of quark entries, using NULL for empty slots.
+ * Slots only ever change from NULL to an entry. When the table grows, a new
+ * table is published and the old one is kept alive for concurrent readers.
+ */
+typedef struct xcb_xrm_quark_table_t {
+    /* The table this one has replaced. */
+    struct xcb_xrm_quark_table_t *previous;
+    /* The number of slots. Always a power of two. */
+    size_t size;
+    /* The slots. */
+    xcb_xrm_quark_entry_t *slots[];
+} xcb_xrm_quark_table_t;
+
+/**
+ * Returns the quark for the given string of the given length, interning the
+ * string if necessary. The string does not need to be NUL-terminated.
+ *
+ * @return The quark or NULLQUARK if the string could not be interned.
+ *
+ */
+xcb_xrm_quark_t __xcb_xrm_quark_intern(const char *str, size_t length);
+
+/**
+ * Returns the quark for the given string of the given length without interning
+ * it. The string does not need to be NUL-terminated.
+ *
+ * @return The quark or NULLQUARK if the string has not been interned.
+ *
+ */
+xcb_xrm_quark_t __xcb_xrm_quark_find(const char *str, size_t length);
+
+/**
+ * Returns the string represented by the given quark. The string must not be
+ * modified or freed.
+ *
+ */
+const char *__xcb_xrm_quark_to_string(xcb_xrm_quark_t quark);
+
+#endif /* __QUARK_H__ */
@@ -0,0 +1,91 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#ifndef __QUERY_H__
+#define __QUERY_H__
+
+#include "externals.h"
+
+#include "xcb_xrm.h"
+#include "entry.h"
+
+struct xcb_xrm_query_t {
+    /* The parsed resource name. Since it only has tight bindings, its hash
+     * is computed up front so that entries with the same specifier can be
+     * found in the specifier index of a database. */
+    xcb_xrm_entry_t *name;
+    /* The parsed resource class or NULL if no class was given. It has the same
+     * number of components as the name. */
+    xcb_xrm_entry_t *class;
+};
+
+/* The number of components a query can have to be parsed into a
+ * xcb_xrm_query_buffer_t. */
+#define QUERY_INLINE_COMPONENTS 16
+
+/** An entry with room for QUERY_INLINE_COMPONENTS components. */
+typedef union xcb_xrm_query_entry_t {
+    xcb_xrm_entry_t entry;
+    char storage[sizeof(struct xcb_xrm_entry_t) + QUERY_INLINE_COMPONENTS * sizeof(struct xcb_xrm_component_t)];
+} xcb_xrm_query_entry_t;
+
+/** Memory for a query parsed by __xcb_xrm_query_parse, e.g., on the stack. */
+typedef struct xcb_xrm_query_buffer_t {
+    struct xcb_xrm_query_t query;
+    xcb_xrm_query_entry_t name;
+    xcb_xrm_query_entry_t class;
+} xcb_xrm_query_buffer_t;
+
+/**
+ * Parses the resource name and class strings into a query stored in the given
+ * buffer without allocating any memory. Unlike xcb_xrm_query_from_strings,
+ * component names are not interned, so the query is only good for lookups on
+ * databases which exist at this point.
+ *
+ * @return The query or NULL if the strings could not be parsed. This includes
+ * strings which are valid but cannot be parsed without allocating, e.g.,
+ * because they have more than QUERY_INLINE_COMPONENTS components.
+ *
+ */
+xcb_xrm_query_t *__xcb_xrm_query_parse(xcb_xrm_query_buffer_t *buffer, const char *res_name,
+        const char *res_class);
+
+/**
+ * Returns the name of the query's component at the given position.
+ *
+ */
+xcb_xrm_quark_t __xcb_xrm_query_name(xcb_xrm_query_t *query, int position);
+
+/**
+ * Returns the class of the query's component at the given position or
+ * NULLQUARK if no class was given or it is the same as the name.
+ *
+ */
+xcb_xrm_quark_t __xcb_xrm_query_class(xcb_xrm_query_t *query, int position);
+
+#endif /* __QUERY_H__ */
@@ -36,7 +36,8 @@
 #include "entry.h"
 
 typedef struct xcb_xrm_resource_t {
-    char *value;
+    /* The value of the matched entry. It is owned by the database. */
+    const char *value;
 } xcb_xrm_resource_t;
 
 #endif /* __RESOURCE_H__ */
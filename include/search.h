@@ -0,0 +1,104 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#ifndef __SEARCH_H__
+#define __SEARCH_H__
+
+#include "externals.h"
+
+#include "xcb_xrm.h"
+#include "entry.h"
+#include "node.h"
+#include "quark.h"
+
+/* Initial number of states allocated for a search level. */
+#define SEARCH_LEVEL_INITIAL_SIZE 16
+
+/** A node of the component tree reached by matching a query prefix. */
+typedef struct xcb_xrm_search_state_t {
+    /* The node reached by the prefix. */
+    xcb_xrm_node_t *node;
+    /* Set if the last component of the prefix was skipped by a loose binding,
+     * in which case only loose children may match the next component. */
+    bool loose_only;
+} xcb_xrm_search_state_t;
+
+/**
+ * All states reachable by matching a query prefix, ordered by precedence.
+ *
+ * Since the precedence rules are applied from left to right, the state of a
+ * better matching prefix always wins over all states after it. A lookup can
+ * therefore stop at the first state which leads to an entry.
+ */
+typedef struct xcb_xrm_search_level_t {
+    xcb_xrm_search_state_t *states;
+    /* The number of states in this level. */
+    int num_states;
+    /* The number of allocated states. */
+    int size;
+} xcb_xrm_search_level_t;
+
+struct xcb_xrm_search_list_t {
+    /* The states reached by the prefix of the search list. */
+    xcb_xrm_search_level_t level;
+};
+
+/**
+ * Resets the level to only contain the root node of the component tree.
+ *
+ * @return 0 on success, a negative error code otherwise.
+ *
+ */
+int __xcb_xrm_search_level_init(xcb_xrm_search_level_t *level, xcb_xrm_node_t *root);
+
+/**
+ * Computes the states reached from the given level by matching one more query
+ * component with the given name and class. The class may be NULLQUARK if no
+ * class was given. Any previous contents of next are replaced.
+ *
+ * @return 0 on success, a negative error code otherwise.
+ *
+ */
+int __xcb_xrm_search_level_expand(xcb_xrm_search_level_t *level, xcb_xrm_search_level_t *next,
+        xcb_xrm_quark_t name, xcb_xrm_quark_t class);
+
+/**
+ * Returns the entry matching the final query component with the given name and
+ * class from the given level or NULL if there is none.
+ *
+ */
+xcb_xrm_entry_t *__xcb_xrm_search_level_resolve(xcb_xrm_search_level_t *level,
+        xcb_xrm_quark_t name, xcb_xrm_quark_t class);
+
+/**
+ * Frees the states of the given level.
+ *
+ */
+void __xcb_xrm_search_level_free(xcb_xrm_search_level_t *level);
+
+#endif /* __SEARCH_H__ */
@@ -45,15 +45,28 @@
 #define SUCCESS 0
 #define FAILURE 1
 
+/* The contents of a file, see file_get_contents. */
+typedef struct file_contents_t {
+    char *data;
+    size_t length;
+} file_contents_t;
+
+/* Initial value for hash_bytes. */
+#define HASH_INIT 2166136261u
+
 int str2long(long *out, const char *input, const int base);
 
+uint32_t hash_bytes(uint32_t hash, const void *data, size_t length);
+
 char *get_home_dir_file(const char *filename);
 
 char *resolve_path(const char *path, const char *base);
 
-char *file_get_contents(const char *filename);
+int file_get_contents(const char *filename, file_contents_t *contents);
+
+void file_free_contents(file_contents_t *contents);
 
-char *xcb_util_get_property(xcb_connection_t *conn, xcb_window_t window, xcb_atom_t atom,
+xcb_get_property_reply_t *xcb_util_get_property(xcb_connection_t *conn, xcb_window_t window, xcb_atom_t atom,
         xcb_atom_t type, size_t size);
 
 #endif /* __UTIL_H__ */
@@ -84,6 +84,32 @@ extern "C" {
  */
 typedef struct xcb_xrm_database_t xcb_xrm_database_t;
 
+/**
+ * @struct xcb_xrm_query_t
+ * Reference to a parsed resource query.
+ *
+ * A query holds a resource name and an optional resource class which have
+ * already been parsed, so that applications looking up the same resources
+ * repeatedly only pay for parsing once. A query is not tied to a database and
+ * can be used with any number of databases, e.g., by using @ref
+ * xcb_xrm_resource_get_string_query (). A query must always be free'd by using
+ * @ref xcb_xrm_query_free ().
+ */
+typedef struct xcb_xrm_query_t xcb_xrm_query_t;
+
+/**
+ * @struct xcb_xrm_search_list_t
+ * Reference to a search list.
+ *
+ * A search list holds the result of matching a resource name / class prefix,
+ * e.g., the path of a widget, against a database. Resources below this prefix,
+ * e.g., the widget's attributes, can then be resolved against the search list
+ * without matching the prefix again, similar to XrmQGetSearchList() and
+ * XrmQGetSearchResource(). A search list must always be free'd by using @ref
+ * xcb_xrm_search_list_free ().
+ */
+typedef struct xcb_xrm_search_list_t xcb_xrm_search_list_t;
+
 /**
  * Creates a database similarly to XGetDefault(). For typical applications,
  * this is the recommended way to construct the resource database.
@@ -138,6 +164,21 @@ xcb_xrm_database_t *xcb_xrm_database_from_resource_manager(xcb_connection_t *con
  */
 xcb_xrm_database_t *xcb_xrm_database_from_string(const char *str);
 
+/**
+ * Creates a database from the given buffer of the given length. The buffer
+ * does not need to be NUL-terminated; parsing stops at its end or at the first
+ * NUL byte, whichever comes first. The buffer is parsed in place and not
+ * referenced anymore once this function returns.
+ * If the database could not be created, this function will return NULL.
+ *
+ * @param buf The resource string.
+ * @param len The length of the resource string in bytes.
+ * @returns The database described by the resource string.
+ *
+ * @ingroup xcb_xrm_database_t
+ */
+xcb_xrm_database_t *xcb_xrm_database_from_buffer(const char *buf, size_t len);
+
 /**
  * Creates a database from a given file.
  * If the file cannot be found or opened, NULL is returned.
@@ -173,7 +214,9 @@ void xcb_xrm_database_combine(xcb_xrm_database_t *source_db, xcb_xrm_database_t
 
 /**
  * Inserts a new resource into the database.
- * If the resource already exists, the current value will be replaced.
+ * If the resource already exists, the current value will be replaced. If the
+ * new value is longer than the current one, the memory of the current value
+ * is only released when the database is freed.
  * If NULL is passed for database, a new and empty database will be created and
  * returned in the pointer.
  *
@@ -190,7 +233,9 @@ void xcb_xrm_database_put_resource(xcb_xrm_database_t **database, const char *re
 
 /**
  * Inserts a new resource into the database.
- * If the resource already exists, the current value will be replaced.
+ * If the resource already exists, the current value will be replaced. If the
+ * new value is longer than the current one, the memory of the current value
+ * is only released when the database is freed.
  * If NULL is passed for database, a new and empty database will be created and
  * returned in the pointer.
  *
@@ -199,6 +244,23 @@ void xcb_xrm_database_put_resource(xcb_xrm_database_t **database, const char *re
  */
 void xcb_xrm_database_put_resource_line(xcb_xrm_database_t **database, const char *line);
 
+/**
+ * Enables or disables caching of lookup results for the given database.
+ *
+ * With caching enabled, repeating a lookup which has been done before only
+ * costs a single hash table probe. The cache holds a limited number of
+ * results and is invalidated automatically whenever the database is modified.
+ * Caching is disabled by default.
+ *
+ * Since every lookup updates the cache, lookups against a database with
+ * caching enabled briefly take a lock and are serialized against each other.
+ *
+ * @param database The database to modify.
+ * @param enable Whether lookup results should be cached.
+ * @returns 0 on success, a negative error code otherwise.
+ */
+int xcb_xrm_database_enable_cache(xcb_xrm_database_t *database, bool enable);
+
 /**
  * Destroys the given database.
  *
@@ -224,6 +286,23 @@ void xcb_xrm_database_free(xcb_xrm_database_t *database);
 int xcb_xrm_resource_get_string(xcb_xrm_database_t *database,
         const char *res_name, const char *res_class, char **out);
 
+/**
+ * Find the string value of a resource without copying it.
+ *
+ * Note that the string is owned by the database and must not be modified or
+ * free'd. It is only valid until the database is modified or free'd.
+ *
+ * @param database The database to query.
+ * @param res_name The fully qualified resource name string.
+ * @param res_class The fully qualified resource class string. This argument
+ * may be left empty / NULL, but if given, it must contain the same number of
+ * components as res_name.
+ * @param out Out parameter to which the value will be written.
+ * @returns 0 if the resource was found, a negative error code otherwise.
+ */
+int xcb_xrm_resource_get_string_ref(xcb_xrm_database_t *database,
+        const char *res_name, const char *res_class, const char **out);
+
 /**
  * Find the long value of a resource.
  *
@@ -262,6 +341,166 @@ int xcb_xrm_resource_get_long(xcb_xrm_database_t *database,
 int xcb_xrm_resource_get_bool(xcb_xrm_database_t *database,
         const char *res_name, const char *res_class, bool *out);
 
+/**
+ * Creates a query for the given resource name and class strings.
+ * If the strings cannot be parsed, NULL is returned.
+ *
+ * @param res_name The fully qualified resource name string.
+ * @param res_class The fully qualified resource class string. This argument
+ * may be left empty / NULL, but if given, it must contain the same number of
+ * components as res_name.
+ * @returns The query, which must be free'd using @ref xcb_xrm_query_free ().
+ *
+ * @ingroup xcb_xrm_query_t
+ */
+xcb_xrm_query_t *xcb_xrm_query_from_strings(const char *res_name, const char *res_class);
+
+/**
+ * Creates a query from arrays of resource name and class components, e.g.,
+ * { "urxvt", "background", NULL }.
+ * If a component is not a valid resource name, NULL is returned.
+ *
+ * @param res_name NULL-terminated array of the resource name's components.
+ * @param res_class NULL-terminated array of the resource class's components.
+ * This argument may be left empty / NULL, but if given, it must contain the
+ * same number of components as res_name.
+ * @returns The query, which must be free'd using @ref xcb_xrm_query_free ().
+ *
+ * @ingroup xcb_xrm_query_t
+ */
+xcb_xrm_query_t *xcb_xrm_query_from_arrays(const char **res_name, const char **res_class);
+
+/**
+ * Destroys the given query.
+ *
+ * @param query The query to destroy.
+ *
+ * @ingroup xcb_xrm_query_t
+ */
+void xcb_xrm_query_free(xcb_xrm_query_t *query);
+
+/**
+ * Find the string value of a resource using a query created by, e.g., @ref
+ * xcb_xrm_query_from_strings ().
+ *
+ * Note that the string is owned by the caller and must be free'd.
+ *
+ * @param database The database to query.
+ * @param query The resource to look up.
+ * @param out Out parameter to which the value will be written.
+ * @returns 0 if the resource was found, a negative error code otherwise.
+ */
+int xcb_xrm_resource_get_string_query(xcb_xrm_database_t *database,
+        xcb_xrm_query_t *query, char **out);
+
+/**
+ * Find the string value of a resource using a query without copying it. This
+ * is the cheapest way of looking up a resource repeatedly. Typically, it does
+ * not allocate any memory; only lookups which have to consider an unusually
+ * large part of the database need scratch space on the heap.
+ *
+ * Note that the string is owned by the database and must not be modified or
+ * free'd. It is only valid until the database is modified or free'd.
+ *
+ * @param database The database to query.
+ * @param query The resource to look up.
+ * @param out Out parameter to which the value will be written.
+ * @returns 0 if the resource was found, a negative error code otherwise.
+ */
+int xcb_xrm_resource_get_string_ref_query(xcb_xrm_database_t *database,
+        xcb_xrm_query_t *query, const char **out);
+
+/**
+ * Find the string values of several resources at once without copying them.
+ *
+ * The queries are evaluated together so that queries sharing a common prefix,
+ * e.g., all attributes of one widget, only match this prefix against the
+ * database once. This is considerably cheaper than looking up each resource
+ * on its own.
+ *
+ * Note that the strings are owned by the database and must not be modified or
+ * free'd. They are only valid until the database is modified or free'd.
+ *
+ * @param database The database to query.
+ * @param queries The resources to look up. NULL elements are ignored.
+ * @param num_queries The number of queries.
+ * @param values Array of num_queries elements to which the values will be
+ * written. For every resource which was not found, NULL is written.
+ * @returns The number of resources found or a negative error code.
+ */
+int xcb_xrm_resource_get_batch(xcb_xrm_database_t *database, xcb_xrm_query_t **queries, int num_queries,
+        const char **values);
+
+/**
+ * Creates a search list for the given prefix.
+ *
+ * The search list refers to the database, so it is only valid until the
+ * database is modified or free'd.
+ *
+ * @param database The database to search.
+ * @param prefix The resource name / class prefix, e.g., created by @ref
+ * xcb_xrm_query_from_strings ("urxvt.scrollBar", "URxvt.ScrollBar"). If NULL,
+ * resources are resolved from the top level of the database.
+ * @returns The search list or NULL if it could not be created.
+ *
+ * @ingroup xcb_xrm_search_list_t
+ */
+xcb_xrm_search_list_t *xcb_xrm_search_list_new(xcb_xrm_database_t *database, xcb_xrm_query_t *prefix);
+
+/**
+ * Find the string value of a resource below the prefix of the search list
+ * without copying it. The result is the same as looking up the prefix and the
+ * query combined into one resource name / class.
+ *
+ * Note that the string is owned by the database and must not be modified or
+ * free'd. It is only valid until the database is modified or free'd.
+ *
+ * @param search_list The search list to resolve the query against.
+ * @param query The rest of the resource, typically a single component such as
+ * "background" / "Background".
+ * @param out Out parameter to which the value will be written.
+ * @returns 0 if the resource was found, a negative error code otherwise.
+ *
+ * @ingroup xcb_xrm_search_list_t
+ */
+int xcb_xrm_search_list_get_string_ref(xcb_xrm_search_list_t *search_list, xcb_xrm_query_t *query,
+        const char **out);
+
+/**
+ * Destroys the given search list.
+ *
+ * @param search_list The search list to destroy.
+ *
+ * @ingroup xcb_xrm_search_list_t
+ */
+void xcb_xrm_search_list_free(xcb_xrm_search_list_t *search_list);
+
+/**
+ * Find the long value of a resource using a query. See @ref
+ * xcb_xrm_resource_get_long () for details on the conversion.
+ *
+ * @param database The database to query.
+ * @param query The resource to look up.
+ * @param out Out parameter to which the converted value will be written.
+ * @returns 0 if the resource was found and converted, -1 if the resource was
+ * found but could not be converted and -2 if the resource was not found.
+ */
+int xcb_xrm_resource_get_long_query(xcb_xrm_database_t *database,
+        xcb_xrm_query_t *query, long *out);
+
+/**
+ * Find the bool value of a resource using a query. See @ref
+ * xcb_xrm_resource_get_bool () for details on the conversion.
+ *
+ * @param database The database to query.
+ * @param query The resource to look up.
+ * @param out Out parameter to which the converted value will be written.
+ * @returns 0 if the resource was found and converted, -1 if the resource was
+ * found but could not be converted and -2 if the resource was not found.
+ */
+int xcb_xrm_resource_get_bool_query(xcb_xrm_database_t *database,
+        xcb_xrm_query_t *query, bool *out);
+
 /**
  * @}
  */
@@ -0,0 +1,131 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#include "externals.h"
+
+#include "arena.h"
+#include "util.h"
+
+/* Rounds the given size up to the alignment of arena allocations. */
+#define ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+/* The offset of the usable memory within a chunk. */
+#define CHUNK_HEADER_SIZE ALIGN(sizeof(xcb_xrm_arena_chunk_t))
+
+/*
+ * Allocates zero-initialized memory of the given size from the arena. If
+ * arena is NULL, the memory is allocated with calloc() instead and must be
+ * freed by the caller.
+ *
+ * @return The allocated memory or NULL on failure.
+ *
+ */
+void *__xcb_xrm_arena_alloc(xcb_xrm_arena_t *arena, size_t size) {
+    xcb_xrm_arena_chunk_t *chunk;
+    void *result;
+
+    if (arena == NULL)
+        return calloc(1, size);
+
+    size = ALIGN(size);
+    chunk = arena->chunks;
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        /* Large allocations get a chunk of their own. We put it behind the
+         * current chunk so that the remaining space in there can still be
+         * used. */
+        bool dedicated = size > ARENA_CHUNK_SIZE / 4;
+        size_t chunk_size = dedicated ? size : ARENA_CHUNK_SIZE;
+
+        chunk = calloc(1, CHUNK_HEADER_SIZE + chunk_size);
+        if (chunk == NULL)
+            return NULL;
+        chunk->size = chunk_size;
+
+        if (dedicated && arena->chunks != NULL) {
+            chunk->next = arena->chunks->next;
+            arena->chunks->next = chunk;
+        } else {
+            chunk->next = arena->chunks;
+            arena->chunks = chunk;
+        }
+    }
+
+    result = (char *)chunk + CHUNK_HEADER_SIZE + chunk->used;
+    chunk->used += size;
+    return result;
+}
+
+/*
+ * Copies the first length bytes of the given string into memory allocated
+ * from the arena and NUL-terminates it. If arena is NULL, the memory is
+ * allocated from the heap as in __xcb_xrm_arena_alloc.
+ *
+ */
+char *__xcb_xrm_arena_strndup(xcb_xrm_arena_t *arena, const char *str, size_t length) {
+    char *result = __xcb_xrm_arena_alloc(arena, length + 1);
+    if (result == NULL)
+        return NULL;
+
+    memcpy(result, str, length);
+    result[length] = '\0';
+    return result;
+}
+
+/*
+ * Returns memory of the given size to the arena if it is the most recent
+ * allocation made from it, so that it is handed out again. Otherwise, the
+ * memory stays in use until the arena is freed.
+ *
+ * @return True if the memory was returned to the arena.
+ *
+ */
+bool __xcb_xrm_arena_release(xcb_xrm_arena_t *arena, void *ptr, size_t size) {
+    xcb_xrm_arena_chunk_t *chunk = arena->chunks;
+
+    size = ALIGN(size);
+    if (chunk == NULL || chunk->used < size || (char *)chunk + CHUNK_HEADER_SIZE + chunk->used - size != ptr)
+        return false;
+
+    /* Allocations are zero-initialized, so clear the memory again. */
+    memset(ptr, 0, size);
+    chunk->used -= size;
+    return true;
+}
+
+/*
+ * Releases all memory allocated from the arena. The arena can be used again
+ * afterwards.
+ *
+ */
+void __xcb_xrm_arena_free(xcb_xrm_arena_t *arena) {
+    while (arena->chunks != NULL) {
+        xcb_xrm_arena_chunk_t *next = arena->chunks->next;
+        FREE(arena->chunks);
+        arena->chunks = next;
+    }
+}
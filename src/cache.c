@@ -0,0 +1,166 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#include "externals.h"
+
+#include "cache.h"
+#include "query.h"
+#include "util.h"
+
+/* Loads or stores a field of a slot which may be accessed concurrently. */
+#define LOAD(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define STORE(field, value) __atomic_store_n(&(field), (value), __ATOMIC_RELAXED)
+
+/* Forward declarations */
+static uint32_t __cache_hash(xcb_xrm_query_t *query);
+static bool __cache_matches(xcb_xrm_cache_slot_t *slot, uint32_t hash, xcb_xrm_query_t *query);
+
+/*
+ * Creates a new, empty cache.
+ *
+ */
+xcb_xrm_cache_t *__xcb_xrm_cache_new(void) {
+    return calloc(1, sizeof(struct xcb_xrm_cache_t));
+}
+
+/*
+ * Looks up the result of the query for the given database generation.
+ *
+ * @param value Out parameter to which the cached value (or NULL for a cached
+ * mismatch) will be written.
+ * @return True if the result was cached.
+ *
+ */
+bool __xcb_xrm_cache_find(xcb_xrm_cache_t *cache, uint32_t generation, xcb_xrm_query_t *query,
+        const char **value) {
+    uint32_t hash = __cache_hash(query);
+    xcb_xrm_cache_slot_t *slot = &(cache->slots[hash & (CACHE_SIZE - 1)]);
+    uint32_t sequence = __atomic_load_n(&(slot->sequence), __ATOMIC_ACQUIRE);
+    const char *result;
+    bool found;
+
+    if (sequence % 2 != 0)
+        return false;
+
+    found = LOAD(slot->generation) == generation && __cache_matches(slot, hash, query);
+    result = LOAD(slot->value);
+
+    /* Only trust what was read if no store has started in the meantime. */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (!found || LOAD(slot->sequence) != sequence)
+        return false;
+
+    *value = result;
+    return true;
+}
+
+/*
+ * Stores the result of the query for the given database generation, replacing
+ * whatever was cached in the same slot. Queries with more than
+ * CACHE_MAX_COMPONENTS components are not cached.
+ *
+ */
+void __xcb_xrm_cache_store(xcb_xrm_cache_t *cache, uint32_t generation, xcb_xrm_query_t *query,
+        const char *value) {
+    uint32_t hash = __cache_hash(query);
+    xcb_xrm_cache_slot_t *slot = &(cache->slots[hash & (CACHE_SIZE - 1)]);
+    int length = query->name->num_components;
+    uint32_t sequence = LOAD(slot->sequence);
+
+    if (length > CACHE_MAX_COMPONENTS)
+        return;
+
+    /* If another thread is writing this slot, let it win. */
+    if (sequence % 2 != 0 ||
+            !__atomic_compare_exchange_n(&(slot->sequence), &sequence, sequence + 1, false,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (int i = 0; i < length; i++) {
+        STORE(slot->key[2 * i], __xcb_xrm_query_name(query, i));
+        STORE(slot->key[2 * i + 1], __xcb_xrm_query_class(query, i));
+    }
+
+    STORE(slot->generation, generation);
+    STORE(slot->hash, hash);
+    STORE(slot->length, length);
+    STORE(slot->value, value);
+
+    __atomic_store_n(&(slot->sequence), sequence + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Drops all cached results. Must not run concurrently with lookups, which is
+ * guaranteed since it is only called when the database is modified.
+ *
+ */
+void __xcb_xrm_cache_clear(xcb_xrm_cache_t *cache) {
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        cache->slots[i].generation = 0;
+    }
+}
+
+/*
+ * Destroys the given cache.
+ *
+ */
+void __xcb_xrm_cache_free(xcb_xrm_cache_t *cache) {
+    FREE(cache);
+}
+
+static uint32_t __cache_hash(xcb_xrm_query_t *query) {
+    uint32_t hash = HASH_INIT;
+
+    for (int i = 0; i < query->name->num_components; i++) {
+        xcb_xrm_quark_t name = __xcb_xrm_query_name(query, i);
+        xcb_xrm_quark_t class = __xcb_xrm_query_class(query, i);
+
+        hash = hash_bytes(hash, &name, sizeof(xcb_xrm_quark_t));
+        hash = hash_bytes(hash, &class, sizeof(xcb_xrm_quark_t));
+    }
+
+    return hash;
+}
+
+static bool __cache_matches(xcb_xrm_cache_slot_t *slot, uint32_t hash, xcb_xrm_query_t *query) {
+    int length = LOAD(slot->length);
+
+    if (LOAD(slot->hash) != hash || length != query->name->num_components)
+        return false;
+
+    for (int i = 0; i < length; i++) {
+        if (LOAD(slot->key[2 * i]) != __xcb_xrm_query_name(query, i) ||
+                LOAD(slot->key[2 * i + 1]) != __xcb_xrm_query_class(query, i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -30,6 +30,7 @@
 
 #include "database.h"
 #include "match.h"
+#include "query.h"
 #include "util.h"
 
 #ifndef MAX_INCLUDE_DEPTH
@@ -40,9 +41,21 @@
 #endif
 
 /* Forward declarations */
-static xcb_xrm_database_t *__xcb_xrm_database_from_string(const char *_str, const char *base, int depth);
-static xcb_xrm_database_t *__xcb_xrm_database_from_file(const char *_filename, const char *base, int depth);
+static xcb_xrm_database_t *__xcb_xrm_database_from_buffer(const char *buf, size_t len, const char *base, int depth);
+static xcb_xrm_database_t *__xcb_xrm_database_new(void);
+static void __xcb_xrm_database_parse(xcb_xrm_database_t *database, const char *str, size_t length,
+        const char *base, int depth);
+static void __xcb_xrm_database_include(xcb_xrm_database_t *database, const char *str, size_t length,
+        const char *base, int depth);
+static int __xcb_xrm_database_parse_file(xcb_xrm_database_t *database, const char *_filename,
+        const char *base, int depth);
 static void __xcb_xrm_database_put(xcb_xrm_database_t *database, xcb_xrm_entry_t *entry, bool override);
+static void __xcb_xrm_database_invalidate(xcb_xrm_database_t *database);
+static xcb_xrm_entry_t *__xcb_xrm_database_index_find(xcb_xrm_database_t *database, xcb_xrm_entry_t *entry);
+static int __xcb_xrm_database_index_insert(xcb_xrm_database_t *database, xcb_xrm_entry_t *entry);
+static void __xcb_xrm_database_index_remove(xcb_xrm_database_t *database, xcb_xrm_entry_t *entry);
+static void __xcb_xrm_database_filter_add(xcb_xrm_database_t *database, xcb_xrm_quark_t name);
+static void __xcb_xrm_database_filter_grow(xcb_xrm_database_t *database);
 
 /*
  * Creates a database similarly to XGetDefault(). For typical applications,
@@ -141,15 +154,15 @@ xcb_xrm_database_t *xcb_xrm_database_from_default(xcb_connection_t *conn) {
 xcb_xrm_database_t *xcb_xrm_database_from_resource_manager(xcb_connection_t *conn, xcb_screen_t *screen) {
     xcb_xrm_database_t *database;
 
-    char *resources = xcb_util_get_property(conn, screen->root, XCB_ATOM_RESOURCE_MANAGER,
+    xcb_get_property_reply_t *reply = xcb_util_get_property(conn, screen->root, XCB_ATOM_RESOURCE_MANAGER,
             XCB_ATOM_STRING, 16 * 1024);
-    if (resources == NULL) {
+    if (reply == NULL) {
         return NULL;
     }
 
-    /* Parse the resource string. */
-    database = xcb_xrm_database_from_string(resources);
-    FREE(resources);
+    /* Parse the resource string straight from the reply. */
+    database = xcb_xrm_database_from_buffer(xcb_get_property_value(reply), xcb_get_property_value_length(reply));
+    FREE(reply);
     return database;
 }
 
@@ -163,130 +176,161 @@ xcb_xrm_database_t *xcb_xrm_database_from_resource_manager(xcb_connection_t *con
  * @ingroup xcb_xrm_database_t
  */
 xcb_xrm_database_t *xcb_xrm_database_from_string(const char *str) {
-    return __xcb_xrm_database_from_string(str, NULL, 0);
-}
+    if (str == NULL)
+        str = "";
 
-static xcb_xrm_database_t *__xcb_xrm_database_from_string(const char *_str, const char *base, int depth) {
-    xcb_xrm_database_t *database;
-    char *str;
-    int num_continuations = 0;
-    char *str_continued;
-    char *outwalk;
-    char *saveptr = NULL;
+    return __xcb_xrm_database_from_buffer(str, strlen(str), NULL, 0);
+}
 
-    if (_str == NULL)
+/*
+ * Creates a database from the given buffer of the given length. The buffer
+ * does not need to be NUL-terminated; parsing stops at its end or at the first
+ * NUL byte, whichever comes first.
+ * If the database could not be created, this function will return NULL.
+ *
+ * @param buf The resource string.
+ * @param len The length of the resource string in bytes.
+ * @returns The database described by the resource string.
+ *
+ * @ingroup xcb_xrm_database_t
+ */
+xcb_xrm_database_t *xcb_xrm_database_from_buffer(const char *buf, size_t len) {
+    if (buf == NULL)
         return xcb_xrm_database_from_string("");
 
-    str = strdup(_str);
-    if (str == NULL)
+    return __xcb_xrm_database_from_buffer(buf, len, NULL, 0);
+}
+
+static xcb_xrm_database_t *__xcb_xrm_database_from_buffer(const char *buf, size_t len, const char *base, int depth) {
+    xcb_xrm_database_t *database;
+
+    database = __xcb_xrm_database_new();
+    if (database == NULL)
         return NULL;
 
-    /* Count the number of line continuations. */
-    for (char *walk = str; *walk != '\0'; walk++) {
-        if (*walk == '\\' && *(walk + 1) == '\n') {
-            num_continuations++;
+    __xcb_xrm_database_parse(database, buf, len, base, depth);
+    return database;
+}
+
+/*
+ * Parses the resource lines in the given buffer into the database, stopping at
+ * the first NUL byte. The buffer is read in place, with line continuations
+ * handled on the fly, so that the only memory allocated is the storage of the
+ * resulting entries.
+ *
+ */
+static void __xcb_xrm_database_parse(xcb_xrm_database_t *database, const char *str, size_t length,
+        const char *base, int depth) {
+    const char *end = str + length;
+    const char *line = str;
+    const char *nul;
+
+    nul = (length == 0) ? NULL : memchr(str, '\0', length);
+    if (nul != NULL)
+        end = nul;
+
+    while (line < end) {
+        const char *first = line;
+        const char *eol = line;
+        xcb_xrm_entry_t *entry;
+
+        /* A newline preceded by a backslash continues the line. */
+        for (;;) {
+            eol = memchr(eol, '\n', end - eol);
+            if (eol == NULL) {
+                eol = end;
+                break;
+            }
+
+            if (eol == line || *(eol - 1) != '\\')
+                break;
+
+            eol++;
         }
-    }
 
-    /* Take care of line continuations. */
-    str_continued = calloc(1, strlen(str) + 1 - 2 * num_continuations);
-    if (str_continued == NULL) {
-        FREE(str);
-        return NULL;
+        /* Empty lines and comments are ignored and lines starting with a '#'
+         * are directives. The specification guarantees that no whitespace is
+         * allowed before these characters. */
+        while (first + 1 < eol && first[0] == '\\' && first[1] == '\n')
+            first += 2;
+
+        if (first < eol && *first == '#') {
+            __xcb_xrm_database_include(database, line, eol - line, base, depth);
+        } else if (first < eol && *first != '!' &&
+                __xcb_xrm_entry_parse_buffer(line, eol - line, true, &entry, false, &(database->arena)) == 0) {
+            __xcb_xrm_database_put(database, entry, true);
+        }
+
+        line = eol + 1;
     }
+}
 
-    outwalk = str_continued;
-    for (char *walk = str; *walk != '\0'; walk++) {
-        if (*walk == '\\' && *(walk + 1) == '\n') {
-            walk++;
+/*
+ * Handles an include directive if the given line, which starts with a '#', is
+ * one. Any other directive is ignored.
+ *
+ */
+static void __xcb_xrm_database_include(xcb_xrm_database_t *database, const char *str, size_t length,
+        const char *base, int depth) {
+    char *line;
+    size_t line_length = 0;
+    int i = 1;
+    int j;
+
+    if (depth >= MAX_INCLUDE_DEPTH)
+        return;
+
+    /* Directives are rare, so it is fine to copy them with the line
+     * continuations removed. */
+    line = malloc(length + 1);
+    if (line == NULL)
+        return;
+
+    for (size_t pos = 0; pos < length; pos++) {
+        if (str[pos] == '\\' && pos + 1 < length && str[pos + 1] == '\n') {
+            pos++;
             continue;
         }
 
-        *(outwalk++) = *walk;
+        line[line_length++] = str[pos];
     }
-    *outwalk = '\0';
-
-    database = calloc(1, sizeof(struct xcb_xrm_database_t));
-    if (database == NULL) {
-        FREE(str);
-        FREE(str_continued);
-        return NULL;
+    line[line_length] = '\0';
+
+    /* Skip whitespace and quotes. */
+    while (line[i] == ' ' || line[i] == '\t')
+        i++;
+
+    if (line[i++] != 'i' ||
+            line[i++] != 'n' ||
+            line[i++] != 'c' ||
+            line[i++] != 'l' ||
+            line[i++] != 'u' ||
+            line[i++] != 'd' ||
+            line[i++] != 'e') {
+        FREE(line);
+        return;
     }
 
-    TAILQ_INIT(database);
-
-    for (char *line = strtok_r(str_continued, "\n", &saveptr); line != NULL; line = strtok_r(NULL, "\n", &saveptr)) {
-        /* Handle include directives. */
-        if (line[0] == '#') {
-            int i = 1;
-
-            /* Skip whitespace and quotes. */
-            while (line[i] == ' ' || line[i] == '\t')
-                i++;
-
-            if (depth < MAX_INCLUDE_DEPTH &&
-                    line[i++] == 'i' &&
-                    line[i++] == 'n' &&
-                    line[i++] == 'c' &&
-                    line[i++] == 'l' &&
-                    line[i++] == 'u' &&
-                    line[i++] == 'd' &&
-                    line[i++] == 'e') {
-                xcb_xrm_database_t *included;
-                char *filename;
-                char *copy;
-                char *new_base;
-                int j = strlen(line) - 1;
-
-                /* Skip whitespace and quotes. */
-                while (line[i] == ' ' || line[i] == '\t' || line[i] == '"')
-                    i++;
-                while (line[j] == ' ' || line[j] == '\t' || line[j] == '"')
-                    j--;
-
-                if (j < i) {
-                    /* Only whitespace left in this line. */
-                    continue;
-                }
-
-                line[j+1] = '\0';
-                filename = resolve_path(&line[i], base);
-                if (filename == NULL)
-                    continue;
-
-                /* We need to strdup() the filename since dirname() will modify it. */
-                copy = strdup(filename);
-                if (copy == NULL) {
-                    FREE(filename);
-                    continue;
-                }
-
-                new_base = dirname(copy);
-                if (new_base == NULL) {
-                    FREE(filename);
-                    FREE(copy);
-                    continue;
-                }
-
-                included = __xcb_xrm_database_from_file(filename, new_base, depth + 1);
-                FREE(filename);
-                FREE(copy);
-
-                if (included != NULL) {
-                    xcb_xrm_database_combine(included, &database, true);
-                    xcb_xrm_database_free(included);
-                }
-
-                continue;
-            }
-        }
+    j = line_length - 1;
+
+    /* Skip whitespace and quotes. */
+    while (line[i] == ' ' || line[i] == '\t' || line[i] == '"')
+        i++;
+    while (line[j] == ' ' || line[j] == '\t' || line[j] == '"')
+        j--;
 
-        xcb_xrm_database_put_resource_line(&database, line);
+    if (j < i) {
+        /* Only whitespace left in this line. */
+        FREE(line);
+        return;
     }
 
-    FREE(str);
-    FREE(str_continued);
-    return database;
+    line[j+1] = '\0';
+
+    /* The included entries are put straight into this database, overriding
+     * the entries defined so far just like the lines of this file do. */
+    __xcb_xrm_database_parse_file(database, &line[i], base, depth + 1);
+    FREE(line);
 }
 
 /*
@@ -297,44 +341,64 @@ static xcb_xrm_database_t *__xcb_xrm_database_from_string(const char *_str, cons
  * @returns The database described by the file's contents.
  */
 xcb_xrm_database_t *xcb_xrm_database_from_file(const char *filename) {
-    return __xcb_xrm_database_from_file(filename, NULL, 0);
+    xcb_xrm_database_t *database;
+
+    if (filename == NULL)
+        return NULL;
+
+    database = __xcb_xrm_database_new();
+    if (database == NULL)
+        return NULL;
+
+    if (__xcb_xrm_database_parse_file(database, filename, NULL, 0) < 0) {
+        xcb_xrm_database_free(database);
+        return NULL;
+    }
+
+    return database;
 }
 
-static xcb_xrm_database_t *__xcb_xrm_database_from_file(const char *_filename, const char *base, int depth) {
+/*
+ * Parses the given file into the database. A relative filename is resolved
+ * against base or, if base is NULL, the current working directory. Includes
+ * in the file are resolved against the directory of the file itself.
+ *
+ * @return 0 on success, a negative error code if the file cannot be read.
+ *
+ */
+static int __xcb_xrm_database_parse_file(xcb_xrm_database_t *database, const char *_filename,
+        const char *base, int depth) {
     char *filename = NULL;
     char *copy = NULL;
     char *new_base = NULL;
-    char *content = NULL;
-    xcb_xrm_database_t *database = NULL;
-
-    if (_filename == NULL)
-        return NULL;
+    file_contents_t contents = { NULL, 0 };
+    int result = -FAILURE;
 
     filename = resolve_path(_filename, base);
     if (filename == NULL)
-        return NULL;
+        return -FAILURE;
 
     /* We need to strdup() the filename since dirname() will modify it. */
     copy = strdup(filename);
     if (copy == NULL)
-        goto done_from_file;
+        goto done_parse_file;
 
     new_base = dirname(copy);
     if (new_base == NULL)
-        goto done_from_file;
+        goto done_parse_file;
 
-    content = file_get_contents(filename);
-    if (content == NULL)
-        goto done_from_file;
+    if (file_get_contents(filename, &contents) < 0)
+        goto done_parse_file;
 
-    database = __xcb_xrm_database_from_string(content, new_base, depth);
+    __xcb_xrm_database_parse(database, contents.data, contents.length, new_base, depth);
+    result = SUCCESS;
 
-done_from_file:
+done_parse_file:
     FREE(filename);
     FREE(copy);
-    FREE(content);
+    file_free_contents(&contents);
 
-    return database;
+    return result;
 }
 
 /*
@@ -351,7 +415,7 @@ char *xcb_xrm_database_to_string(xcb_xrm_database_t *database) {
     if (database == NULL)
         return NULL;
 
-    TAILQ_FOREACH(entry, database, entries) {
+    TAILQ_FOREACH(entry, &(database->entries), entries) {
         char *entry_str = __xcb_xrm_entry_to_string(entry);
         char *tmp;
         if (asprintf(&tmp, "%s%s\n", result == NULL ? "" : result, entry_str) < 0) {
@@ -391,8 +455,14 @@ void xcb_xrm_database_combine(xcb_xrm_database_t *source_db, xcb_xrm_database_t
     if (source_db == *target_db)
         return;
 
-    TAILQ_FOREACH(entry, source_db, entries) {
-        xcb_xrm_entry_t *copy = __xcb_xrm_entry_copy(entry);
+    TAILQ_FOREACH(entry, &(source_db->entries), entries) {
+        xcb_xrm_entry_t *copy;
+
+        /* Avoid copying entries which would be discarded anyway. */
+        if (!override && __xcb_xrm_database_index_find(*target_db, entry) != NULL)
+            continue;
+
+        copy = __xcb_xrm_entry_copy(entry, &((*target_db)->arena));
         __xcb_xrm_database_put(*target_db, copy, override);
     }
 }
@@ -456,7 +526,7 @@ void xcb_xrm_database_put_resource_line(xcb_xrm_database_t **database, const cha
     if (line[0] == '!' || line[0] == '#')
         return;
 
-    if (xcb_xrm_entry_parse(line, &entry, false) == 0) {
+    if (xcb_xrm_entry_parse(line, &entry, false, &((*database)->arena)) == 0) {
         __xcb_xrm_database_put(*database, entry, true);
     }
 }
@@ -472,13 +542,84 @@ void xcb_xrm_database_free(xcb_xrm_database_t *database) {
     if (database == NULL)
         return;
 
-    while (!TAILQ_EMPTY(database)) {
-        xcb_xrm_entry_t *entry = TAILQ_FIRST(database);
-        TAILQ_REMOVE(database, entry, entries);
-        xcb_xrm_entry_free(entry);
+    /* All entries and nodes are allocated from the arena. */
+    __xcb_xrm_arena_free(&(database->arena));
+    __xcb_xrm_cache_free(database->cache);
+    FREE(database->index);
+    FREE(database->filter);
+    FREE(database);
+}
+
+/*
+ * Enables or disables caching of lookup results for the given database.
+ *
+ * @param database The database to modify.
+ * @param enable Whether lookup results should be cached.
+ * @returns 0 on success, a negative error code otherwise.
+ */
+int xcb_xrm_database_enable_cache(xcb_xrm_database_t *database, bool enable) {
+    if (database == NULL)
+        return -FAILURE;
+
+    if (!enable) {
+        __xcb_xrm_cache_free(database->cache);
+        database->cache = NULL;
+        return SUCCESS;
     }
 
-    FREE(database);
+    if (database->cache == NULL) {
+        database->cache = __xcb_xrm_cache_new();
+        if (database->cache == NULL)
+            return -FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/*
+ * Returns false if no entry of the database can match the query since neither
+ * the final name nor the final class of the query ends any entry. Otherwise,
+ * the query may or may not match.
+ *
+ */
+bool __xcb_xrm_database_filter_test(xcb_xrm_database_t *database, xcb_xrm_query_t *query) {
+    int last = query->name->num_components - 1;
+    xcb_xrm_quark_t class = __xcb_xrm_query_class(query, last);
+
+    if (__xcb_xrm_database_filter_contains(database, __xcb_xrm_query_name(query, last)))
+        return true;
+
+    return class != NULLQUARK && __xcb_xrm_database_filter_contains(database, class);
+}
+
+/*
+ * Returns the entry whose specifier is the query's resource name with only
+ * tight bindings or NULL if there is none. Such an entry matches every
+ * component by name through a tight binding, so it takes precedence over any
+ * other entry matching the query.
+ *
+ */
+xcb_xrm_entry_t *__xcb_xrm_database_find_exact(xcb_xrm_database_t *database, xcb_xrm_query_t *query) {
+    return __xcb_xrm_database_index_find(database, query->name);
+}
+
+static xcb_xrm_database_t *__xcb_xrm_database_new(void) {
+    xcb_xrm_database_t *database = calloc(1, sizeof(struct xcb_xrm_database_t));
+    if (database == NULL)
+        return NULL;
+
+    TAILQ_INIT(&(database->entries));
+
+    database->filter = calloc(FILTER_INITIAL_BITS / 64, sizeof(uint64_t));
+    database->filter_shift = 64 - __builtin_ctzll(FILTER_INITIAL_BITS);
+    database->root = __xcb_xrm_node_new(&(database->arena));
+    if (database->filter == NULL || database->root == NULL) {
+        FREE(database->filter);
+        FREE(database);
+        return NULL;
+    }
+
+    return database;
 }
 
 static void __xcb_xrm_database_put(xcb_xrm_database_t *database, xcb_xrm_entry_t *entry, bool override) {
@@ -488,28 +629,163 @@ static void __xcb_xrm_database_put(xcb_xrm_database_t *database, xcb_xrm_entry_t
         return;
 
     /* Let's see whether this is a duplicate entry. */
-    current = TAILQ_FIRST(database);
+    entry->hash = __xcb_xrm_entry_hash(entry);
+    current = __xcb_xrm_database_index_find(database, entry);
+    if (current != NULL && !override)
+        return;
+
+    __xcb_xrm_database_invalidate(database);
+
+    /* Overriding a value with one that is no longer is done in place, so
+     * that the replaced entry's memory does not stay unused in the arena. */
+    if (current != NULL && __xcb_xrm_entry_replace_value(current, entry, &(database->arena))) {
+        TAILQ_REMOVE(&(database->entries), current, entries);
+        TAILQ_INSERT_TAIL(&(database->entries), current, entries);
+        return;
+    }
+
+    if (__xcb_xrm_database_index_insert(database, entry) < 0)
+        return;
+
+    /* This replaces a duplicate entry in the tree as both lead to the same
+     * node. */
+    if (__xcb_xrm_node_insert(database->root, entry, &(database->arena)) < 0) {
+        __xcb_xrm_database_index_remove(database, entry);
+        return;
+    }
+
+    __xcb_xrm_database_filter_add(database, entry->components[entry->num_components - 1].name);
+
+    /* Otherwise, the replaced entry's memory is only released along with the
+     * arena. */
+    if (current != NULL) {
+        __xcb_xrm_database_index_remove(database, current);
+        TAILQ_REMOVE(&(database->entries), current, entries);
+    }
+
+    TAILQ_INSERT_TAIL(&(database->entries), entry, entries);
+}
+
+/*
+ * Discards everything derived from the current contents of the database.
+ *
+ */
+static void __xcb_xrm_database_invalidate(xcb_xrm_database_t *database) {
+    /* Any cached lookup results are outdated now. The generation 0 marks
+     * unused cache slots, so skip it when wrapping around. */
+    if (++(database->generation) == 0) {
+        database->generation = 1;
+        if (database->cache != NULL)
+            __xcb_xrm_cache_clear(database->cache);
+    }
+}
+
+static xcb_xrm_entry_t *__xcb_xrm_database_index_find(xcb_xrm_database_t *database, xcb_xrm_entry_t *entry) {
+    xcb_xrm_entry_t *current;
+
+    if (database->index == NULL)
+        return NULL;
+
+    current = database->index[entry->hash & (database->index_size - 1)];
     while (current != NULL) {
-        xcb_xrm_entry_t *previous = TAILQ_PREV(current, xcb_xrm_database_t, entries);
+        if (current->hash == entry->hash && __xcb_xrm_entry_compare(entry, current) == 0)
+            return current;
 
-        if (__xcb_xrm_entry_compare(entry, current) == 0) {
-            if (!override) {
-                xcb_xrm_entry_free(entry);
-                return;
+        current = current->index_next;
+    }
+
+    return NULL;
+}
+
+static int __xcb_xrm_database_index_insert(xcb_xrm_database_t *database, xcb_xrm_entry_t *entry) {
+    xcb_xrm_entry_t **bucket;
+
+    /* Grow the index once the load factor exceeds one so that the chains
+     * stay short. */
+    if (database->num_entries >= database->index_size) {
+        size_t new_size = database->index_size == 0 ? INDEX_INITIAL_SIZE : 2 * database->index_size;
+        xcb_xrm_entry_t **new_index = calloc(new_size, sizeof(xcb_xrm_entry_t *));
+        if (new_index == NULL)
+            return -FAILURE;
+
+        for (size_t i = 0; i < database->index_size; i++) {
+            xcb_xrm_entry_t *current = database->index[i];
+            while (current != NULL) {
+                xcb_xrm_entry_t *next = current->index_next;
+
+                bucket = &(new_index[current->hash & (new_size - 1)]);
+                current->index_next = *bucket;
+                *bucket = current;
+
+                current = next;
             }
+        }
 
-            TAILQ_REMOVE(database, current, entries);
-            xcb_xrm_entry_free(current);
+        FREE(database->index);
+        database->index = new_index;
+        database->index_size = new_size;
+    }
 
-            current = previous;
-            if (current == NULL)
-                current = TAILQ_FIRST(database);
+    bucket = &(database->index[entry->hash & (database->index_size - 1)]);
+    entry->index_next = *bucket;
+    *bucket = entry;
+    database->num_entries++;
+
+    return SUCCESS;
+}
+
+static void __xcb_xrm_database_index_remove(xcb_xrm_database_t *database, xcb_xrm_entry_t *entry) {
+    xcb_xrm_entry_t **walk = &(database->index[entry->hash & (database->index_size - 1)]);
+
+    while (*walk != NULL) {
+        if (*walk == entry) {
+            *walk = entry->index_next;
+            entry->index_next = NULL;
+            database->num_entries--;
+            return;
         }
 
-        if (current == NULL)
-            break;
-        current = TAILQ_NEXT(current, entries);
+        walk = &((*walk)->index_next);
     }
+}
+
+static void __xcb_xrm_database_filter_add(xcb_xrm_database_t *database, xcb_xrm_quark_t name) {
+    uint64_t first;
+    uint64_t second;
+
+    if (__xcb_xrm_database_filter_contains(database, name))
+        return;
+
+    if ((database->filter_names + 1) * FILTER_BITS_PER_NAME > (uint64_t)1 << (64 - database->filter_shift))
+        __xcb_xrm_database_filter_grow(database);
+
+    first = FILTER_BIT_FIRST(name, database->filter_shift);
+    second = FILTER_BIT_SECOND(name, database->filter_shift);
+    database->filter[first / 64] |= (uint64_t)1 << (first % 64);
+    database->filter[second / 64] |= (uint64_t)1 << (second % 64);
+    database->filter_names++;
+}
+
+/*
+ * Doubles the size of the filter and adds the final names of all entries to it
+ * again. If this fails, the old filter is kept; it is still correct, but passes
+ * more names by chance.
+ *
+ */
+static void __xcb_xrm_database_filter_grow(xcb_xrm_database_t *database) {
+    size_t words = ((size_t)1 << (64 - database->filter_shift)) / 64;
+    uint64_t *filter = calloc(2 * words, sizeof(uint64_t));
+    xcb_xrm_entry_t *entry;
+
+    if (filter == NULL)
+        return;
 
-    TAILQ_INSERT_TAIL(database, entry, entries);
+    FREE(database->filter);
+    database->filter = filter;
+    database->filter_shift--;
+    database->filter_names = 0;
+
+    TAILQ_FOREACH(entry, &(database->entries), entries) {
+        __xcb_xrm_database_filter_add(database, entry->components[entry->num_components - 1].name);
+    }
 }
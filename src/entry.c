@@ -29,295 +29,380 @@
 #include "externals.h"
 
 #include "entry.h"
+#include "scan.h"
 #include "util.h"
 
-#define BUFFER_SIZE 1024
-
 /**
- * Appends a single character to the current buffer.
- * If the buffer is not yet initialized or has been invalidated, it will be set up.
+ * Appends the given characters to the name of the current component. As long
+ * as the name is contiguous in the parsed string, it is merely extended;
+ * otherwise, it is joined in the scratch buffer.
+ *
+ * @return 0 on success, a negative error code otherwise.
  *
  */
-static void xcb_xrm_append_char(xcb_xrm_entry_t *entry, xcb_xrm_entry_parser_state_t *state,
-        const char str) {
-    ptrdiff_t offset;
-
-    if (state->buffer_pos == NULL) {
-        FREE(state->buffer);
-        state->buffer = calloc(1, BUFFER_SIZE);
-        state->buffer_pos = state->buffer;
-        if (state->buffer == NULL) {
-            /* Let's ignore this character and try again next time. */
-            return;
-        }
+static int xcb_xrm_append_chars(xcb_xrm_entry_parser_state_t *state, const char *str, size_t length) {
+    if (state->name_length == 0) {
+        state->name = str;
+        state->name_length = length;
+        return SUCCESS;
     }
 
-    /* Increase the buffer if necessary. */
-    offset = state->buffer_pos - state->buffer;
-    if (offset % BUFFER_SIZE == BUFFER_SIZE - 1) {
-        state->buffer = realloc(state->buffer, offset + BUFFER_SIZE + 1);
-        state->buffer_pos = state->buffer + offset;
+    if (state->name + state->name_length == str) {
+        state->name_length += length;
+        return SUCCESS;
+    }
+
+    if (state->name_length + length > state->buffer_size) {
+        size_t size = 2 * (state->name_length + length);
+        bool joined = (state->name == state->buffer);
+        char *buffer = realloc(state->buffer, size);
+        if (buffer == NULL)
+            return -FAILURE;
+
+        if (joined)
+            state->name = buffer;
+        state->buffer = buffer;
+        state->buffer_size = size;
     }
 
-    *(state->buffer_pos++) = str;
+    if (state->name != state->buffer) {
+        memcpy(state->buffer, state->name, state->name_length);
+        state->name = state->buffer;
+    }
+
+    memcpy(state->buffer + state->name_length, str, length);
+    state->name_length += length;
+    return SUCCESS;
 }
 
 /**
  * Insert a new component of the given type.
- * This function does not check whether there is an open buffer.
+ * If str is not NULL, the component is named after its first length characters.
  *
  */
-static void xcb_xrm_insert_component(xcb_xrm_entry_t *entry, xcb_xrm_component_type_t type,
-        xcb_xrm_binding_type_t binding_type, const char *str) {
-    xcb_xrm_component_t *new = calloc(1, sizeof(struct xcb_xrm_component_t));
-    if (new == NULL)
-        return;
+static void xcb_xrm_insert_component(xcb_xrm_entry_parser_state_t *state,
+        xcb_xrm_component_type_t type, xcb_xrm_binding_type_t binding_type, const char *str, size_t length) {
+    xcb_xrm_component_t *new;
+
+    /* Grow the component list if necessary. Up to PARSER_INLINE_COMPONENTS
+     * components are kept in the parser state itself. */
+    if (state->num_components == state->components_size) {
+        int new_size = state->components_size * 2;
+        xcb_xrm_component_t *components;
+
+        if (state->components == state->inline_components) {
+            components = calloc(new_size, sizeof(struct xcb_xrm_component_t));
+            if (components != NULL)
+                memcpy(components, state->components, state->num_components * sizeof(struct xcb_xrm_component_t));
+        } else {
+            components = realloc(state->components, new_size * sizeof(struct xcb_xrm_component_t));
+        }
+
+        if (components == NULL)
+            return;
 
+        state->components = components;
+        state->components_size = new_size;
+    }
+
+    new = &(state->components[state->num_components]);
+    new->name = NULLQUARK;
     if (str != NULL) {
-        new->name = strdup(str);
-        if (new->name == NULL) {
-            FREE(new);
+        new->name = __xcb_xrm_quark_intern(str, length);
+        if (new->name == NULLQUARK)
             return;
-        }
     }
 
     new->type = type;
     new->binding_type = binding_type;
-    TAILQ_INSERT_TAIL(&(entry->components), new, components);
+    state->num_components++;
 }
 
 /**
- * Finalize the current buffer by writing it into a component if necessary.
- * This function also resets the buffer to a clean slate.
+ * Finalize the current name by writing it into a component if necessary.
+ * This function also resets the name to a clean slate.
  *
  */
-static void xcb_xrm_finalize_component(xcb_xrm_entry_t *entry, xcb_xrm_entry_parser_state_t *state) {
-    if (state->buffer_pos != NULL && state->buffer_pos != state->buffer) {
-        *(state->buffer_pos) = '\0';
-        xcb_xrm_insert_component(entry, CT_NORMAL, state->current_binding_type, state->buffer);
+static void xcb_xrm_finalize_component(xcb_xrm_entry_parser_state_t *state) {
+    if (state->name_length > 0) {
+        xcb_xrm_insert_component(state, CT_NORMAL, state->current_binding_type, state->name, state->name_length);
     }
 
-    FREE(state->buffer);
-    /* No need to handle NULL for this calloc call. */
-    state->buffer = calloc(1, BUFFER_SIZE);
-    state->buffer_pos = state->buffer;
+    state->name_length = 0;
     state->current_binding_type = BT_TIGHT;
 }
 
+/**
+ * Allocates an entry holding a copy of the given components in a single block
+ * of memory. If has_value is set, room for a value of the given length is
+ * reserved in the same block and NUL-terminated; filling it in is up to the
+ * caller.
+ *
+ */
+static size_t __entry_size(int num_components, bool has_value, size_t value_length) {
+    size_t size = sizeof(struct xcb_xrm_entry_t) + num_components * sizeof(struct xcb_xrm_component_t);
+
+    if (has_value)
+        size += value_length + 1;
+
+    return size;
+}
+
+static xcb_xrm_entry_t *__entry_new(xcb_xrm_arena_t *arena, const xcb_xrm_component_t *components,
+        int num_components, bool has_value, size_t value_length) {
+    xcb_xrm_entry_t *entry;
+    size_t components_size = num_components * sizeof(struct xcb_xrm_component_t);
+
+    entry = __xcb_xrm_arena_alloc(arena, __entry_size(num_components, has_value, value_length));
+    if (entry == NULL)
+        return NULL;
+
+    entry->num_components = num_components;
+    memcpy(entry->components, components, components_size);
+
+    if (has_value) {
+        entry->value = (char *)entry->components + components_size;
+        entry->value[value_length] = '\0';
+    }
+
+    return entry;
+}
+
+/**
+ * Returns the position of the first character at or after pos which is not
+ * part of a line continuation, i.e., a backslash followed by a newline. If
+ * continuations is false, pos is returned unchanged.
+ *
+ */
+static size_t __entry_skip(const char *str, size_t length, size_t pos, bool continuations) {
+    if (!continuations)
+        return pos;
+
+    while (pos + 1 < length && str[pos] == '\\' && str[pos + 1] == '\n')
+        pos += 2;
+
+    return pos;
+}
+
+/**
+ * Returns the position of the character following the one at pos, skipping
+ * line continuations if requested.
+ *
+ */
+static size_t __entry_next(const char *str, size_t length, size_t pos, bool continuations) {
+    return __entry_skip(str, length, pos + 1, continuations);
+}
+
+/**
+ * Decodes the value starting at pos, replacing magic values by the characters
+ * they stand for. If out is NULL, the value is only measured.
+ *
+ * @return The length of the decoded value.
+ *
+ */
+static size_t __entry_unescape(const char *str, size_t length, size_t pos, bool continuations, char *out) {
+    size_t value_length = 0;
+
+    while (pos < length) {
+        size_t next;
+        char c = str[pos];
+
+        /* Everything up to the next backslash is copied verbatim. Line
+         * continuations start with a backslash as well. */
+        if (c != '\\') {
+            const char *backslash = memchr(str + pos, '\\', length - pos);
+            size_t end = (backslash == NULL) ? length : (size_t)(backslash - str);
+
+            if (out != NULL)
+                memcpy(out + value_length, str + pos, end - pos);
+            value_length += end - pos;
+            pos = __entry_skip(str, length, end, continuations);
+            continue;
+        }
+
+        next = __entry_next(str, length, pos, continuations);
+
+        if (next < length) {
+            char escaped = str[next];
+            size_t second = __entry_next(str, length, next, continuations);
+            size_t third = __entry_next(str, length, second, continuations);
+
+            if (escaped == ' ' || escaped == '\t' || escaped == '\\') {
+                c = escaped;
+                next = second;
+            } else if (escaped == 'n') {
+                c = '\n';
+                next = second;
+            } else if (third < length &&
+                    escaped >= '0' && escaped < '8' &&
+                    str[second] >= '0' && str[second] < '8' &&
+                    str[third] >= '0' && str[third] < '8') {
+                c = (escaped - '0') * 64 + (str[second] - '0') * 8 + (str[third] - '0');
+                next = __entry_next(str, length, third, continuations);
+            }
+        }
+
+        if (out != NULL)
+            out[value_length] = c;
+        value_length++;
+        pos = next;
+    }
+
+    return value_length;
+}
+
 /*
  * Parses a specific resource string.
  *
  * @param str The resource string.
- * @param entry A return struct that will contain the parsed resource. The
- * memory will be allocated dynamically, so it must be freed.
+ * @param entry A return struct that will contain the parsed resource.
  * @param resource_only If true, only components of type CT_NORMAL are allowed.
+ * @param arena The arena to allocate the entry from. If NULL, the entry is
+ * allocated dynamically and must be freed using xcb_xrm_entry_free.
+ *
+ * @return 0 on success, a negative error code otherwise.
+ *
+ */
+int xcb_xrm_entry_parse(const char *str, xcb_xrm_entry_t **entry, bool resource_only, xcb_xrm_arena_t *arena) {
+    return __xcb_xrm_entry_parse_buffer(str, strlen(str), false, entry, resource_only, arena);
+}
+
+/*
+ * Parses a resource string of the given length which does not need to be
+ * NUL-terminated. If continuations is set, any backslash followed by a newline
+ * is ignored as a line continuation.
  *
  * @return 0 on success, a negative error code otherwise.
  *
  */
-int xcb_xrm_entry_parse(const char *_str, xcb_xrm_entry_t **_entry, bool resource_only) {
-    char *str;
-    xcb_xrm_entry_t *entry = NULL;
-    xcb_xrm_component_t *last;
-    char *value;
-    char *value_walk;
+int __xcb_xrm_entry_parse_buffer(const char *str, size_t length, bool continuations, xcb_xrm_entry_t **_entry,
+        bool resource_only, xcb_xrm_arena_t *arena) {
     xcb_xrm_binding_type_t binding_type;
+    size_t value_length = 0;
+    size_t pos;
+    size_t next;
+    size_t end;
+    int result = -FAILURE;
 
     xcb_xrm_entry_parser_state_t state = {
         .chunk = CS_INITIAL,
         .current_binding_type = BT_TIGHT,
+        .components_size = PARSER_INLINE_COMPONENTS,
     };
 
-    /* Copy the input string since it's const. */
-    str = strdup(_str);
-    if (str == NULL)
-        return -FAILURE;
-
-    /* This is heavily overestimated, but we'll just keep it simple here.
-     * While this does not account for replacement of magic values, those only
-     * make the resulting string shorter than the input, so we're okay. */
-    value = calloc(1, strlen(str));
-    if (value == NULL) {
-        FREE(str);
-        return -FAILURE;
-    }
-    value_walk = value;
-
-    /* Allocate memory for the return parameter. */
-    *_entry = calloc(1, sizeof(struct xcb_xrm_entry_t));
-    if (_entry == NULL) {
-        FREE(str);
-        FREE(value);
-        return -FAILURE;
-    }
+    state.components = state.inline_components;
+    *_entry = NULL;
 
-    entry = *_entry;
-    TAILQ_INIT(&(entry->components));
+    /* Parse the components up to the ':' separating them from the value. */
+    for (pos = __entry_skip(str, length, 0, continuations);
+            pos < length && state.chunk < CS_PRE_VALUE_WHITESPACE;
+            pos = next) {
+        next = __entry_next(str, length, pos, continuations);
 
-    for (char *walk = str; *walk != '\0'; walk++) {
-        switch (*walk) {
+        switch (str[pos]) {
             case '.':
             case '*':
-                state.chunk = MAX(state.chunk, CS_COMPONENTS);
-                if (state.chunk >= CS_PRE_VALUE_WHITESPACE) {
-                    goto process_normally;
-                }
+                state.chunk = CS_COMPONENTS;
 
-                if (*walk == '*' && resource_only) {
-                    goto done_error;
+                if (str[pos] == '*' && resource_only) {
+                    goto done_parse;
                 }
 
                 /* Subsequent bindings must be collapsed into a loose binding if at
                  * least one was a loose binding and a tight binding otherwise. */
-                binding_type = (*walk == '*') ? BT_LOOSE : BT_TIGHT;
-                while (*(walk + 1) == '.' || *(walk + 1) == '*') {
-                    walk++;
-
-                    if (*walk == '*') {
+                binding_type = (str[pos] == '*') ? BT_LOOSE : BT_TIGHT;
+                while (next < length && (str[next] == '.' || str[next] == '*')) {
+                    if (str[next] == '*') {
                         binding_type = BT_LOOSE;
                     }
+
+                    next = __entry_next(str, length, next, continuations);
                 }
 
-                xcb_xrm_finalize_component(entry, &state);
+                xcb_xrm_finalize_component(&state);
                 state.current_binding_type = binding_type;
                 break;
             case '?':
-                state.chunk = MAX(state.chunk, CS_COMPONENTS);
-                if (state.chunk >= CS_PRE_VALUE_WHITESPACE) {
-                    goto process_normally;
-                }
+                state.chunk = CS_COMPONENTS;
 
                 if (resource_only) {
-                    goto done_error;
+                    goto done_parse;
                 }
 
-                xcb_xrm_insert_component(entry, CT_WILDCARD, state.current_binding_type, NULL);
+                xcb_xrm_insert_component(&state, CT_WILDCARD, state.current_binding_type, NULL, 0);
                 break;
             case ' ':
             case '\t':
-                /* Spaces are only allowed in the value, but spaces between the
-                 * ':' and the value are omitted. */
-                if (state.chunk <= CS_PRE_VALUE_WHITESPACE) {
-                    break;
-                }
-
-                goto process_normally;
+                /* Spaces are only allowed in the value. */
+                break;
             case ':':
-                if (resource_only) {
-                    goto done_error;
+                if (resource_only || state.chunk == CS_INITIAL) {
+                    goto done_parse;
                 }
 
-                if (state.chunk == CS_INITIAL) {
-                    goto done_error;
-                } else if (state.chunk == CS_COMPONENTS) {
-                    xcb_xrm_finalize_component(entry, &state);
-                    state.chunk = CS_PRE_VALUE_WHITESPACE;
-                    break;
-                } else if (state.chunk >= CS_PRE_VALUE_WHITESPACE) {
-                    state.chunk = CS_VALUE;
-                    goto process_normally;
-                }
+                xcb_xrm_finalize_component(&state);
+                state.chunk = CS_PRE_VALUE_WHITESPACE;
                 break;
             default:
-process_normally:
-                state.chunk = MAX(state.chunk, CS_COMPONENTS);
-
-                if (state.chunk == CS_PRE_VALUE_WHITESPACE) {
-                    state.chunk = CS_VALUE;
-                }
-
-                if (state.chunk == CS_COMPONENTS) {
-                    if ((*walk != '_' && *walk != '-') &&
-                            (*walk < '0' || *walk > '9') &&
-                            (*walk < 'a' || *walk > 'z') &&
-                            (*walk < 'A' || *walk > 'Z')) {
-                        goto done_error;
-                    }
+                /* Take the whole run of name characters at once. It ends at
+                 * any special character, including the backslash of a line
+                 * continuation. */
+                end = __xcb_xrm_scan_name(str, pos, length);
+                if (end == pos) {
+                    goto done_parse;
                 }
 
-                if (state.chunk < CS_VALUE) {
-                    xcb_xrm_append_char(entry, &state, *walk);
-                } else {
-                    if (*walk == '\\') {
-                        if (*(walk + 1) == ' ') {
-                            *(value_walk++) = ' ';
-                            walk++;
-                        } else if (*(walk + 1) == '\t') {
-                            *(value_walk++) = '\t';
-                            walk++;
-                        } else if (*(walk + 1) == '\\') {
-                            *(value_walk++) = '\\';
-                            walk++;
-                        } else if (*(walk + 1) == 'n') {
-                            *(value_walk++) = '\n';
-                            walk++;
-                        } else if (isdigit(*(walk + 1)) && isdigit(*(walk + 2)) && isdigit(*(walk + 3)) &&
-                                *(walk + 1) < '8' && *(walk + 2) < '8' && *(walk + 3) < '8') {
-                            *(value_walk++) = (*(walk + 1) - '0') * 64 + (*(walk + 2) - '0') * 8 + (*(walk + 3) - '0');
-                            walk += 3;
-                        } else {
-                            *(value_walk++) = *walk;
-                        }
-                    } else {
-                        *(value_walk++) = *walk;
-                    }
+                state.chunk = CS_COMPONENTS;
+                if (xcb_xrm_append_chars(&state, str + pos, end - pos) < 0) {
+                    goto done_parse;
                 }
 
+                next = __entry_skip(str, length, end, continuations);
                 break;
         }
     }
 
-    if (state.chunk == CS_PRE_VALUE_WHITESPACE || state.chunk == CS_VALUE) {
-        *value_walk = '\0';
-        entry->value = strdup(value);
-        if (entry->value == NULL)
-            goto done_error;
+    if (state.chunk == CS_PRE_VALUE_WHITESPACE) {
+        /* Spaces between the ':' and the value are omitted. */
+        while (pos < length && (str[pos] == ' ' || str[pos] == '\t'))
+            pos = __entry_next(str, length, pos, continuations);
+
+        value_length = __entry_unescape(str, length, pos, continuations, NULL);
     } else if (!resource_only) {
         /* Return error if there was no value for this entry. */
-        goto done_error;
+        goto done_parse;
     } else {
-        /* Since in the case of resource_only we never went into CS_VALUE, we
-         * need to finalize the last component. */
-        xcb_xrm_finalize_component(entry, &state);
+        /* Since in the case of resource_only there is no ':', we need to
+         * finalize the last component. */
+        xcb_xrm_finalize_component(&state);
     }
 
     /* Assert that this entry actually had a resource component. */
-    if ((last = TAILQ_LAST(&(entry->components), components_head)) == NULL) {
-        goto done_error;
+    if (state.num_components == 0) {
+        goto done_parse;
     }
 
     /* Assert that the last component is not a wildcard. */
-    if (last->type != CT_NORMAL) {
-        goto done_error;
+    if (state.components[state.num_components - 1].type != CT_NORMAL) {
+        goto done_parse;
     }
 
-    FREE(str);
-    FREE(value);
-    FREE(state.buffer);
-    return 0;
-
-done_error:
-    FREE(str);
-    FREE(value);
-    FREE(state.buffer);
-
-    xcb_xrm_entry_free(entry);
-    *_entry = NULL;
-    return -1;
-}
+    *_entry = __entry_new(arena, state.components, state.num_components,
+            state.chunk == CS_PRE_VALUE_WHITESPACE, value_length);
+    if (*_entry == NULL) {
+        goto done_parse;
+    }
 
-/*
- * Returns the number of components of the given entry.
- *
- */
-int __xcb_xrm_entry_num_components(xcb_xrm_entry_t *entry) {
-    int result = 0;
+    /* The value is decoded straight into the entry. */
+    if ((*_entry)->value != NULL)
+        __entry_unescape(str, length, pos, continuations, (*_entry)->value);
 
-    xcb_xrm_component_t *current;
-    TAILQ_FOREACH(current, &(entry->components), components) {
-        result++;
-    }
+    result = SUCCESS;
 
+done_parse:
+    FREE(state.buffer);
+    if (state.components != state.inline_components)
+        FREE(state.components);
     return result;
 }
 
@@ -327,30 +412,44 @@ int __xcb_xrm_entry_num_components(xcb_xrm_entry_t *entry) {
  *
  */
 int __xcb_xrm_entry_compare(xcb_xrm_entry_t *first, xcb_xrm_entry_t *second) {
-    xcb_xrm_component_t *comp_first = TAILQ_FIRST(&(first->components));
-    xcb_xrm_component_t *comp_second = TAILQ_FIRST(&(second->components));
+    if (first->num_components != second->num_components)
+        return -FAILURE;
+
+    for (int i = 0; i < first->num_components; i++) {
+        xcb_xrm_component_t *comp_first = &(first->components[i]);
+        xcb_xrm_component_t *comp_second = &(second->components[i]);
 
-    while (comp_first != NULL && comp_second != NULL) {
         if (comp_first->type != comp_second->type)
             return -FAILURE;
 
         if (comp_first->binding_type != comp_second->binding_type)
             return -FAILURE;
 
-        if (comp_first->type == CT_NORMAL && strcmp(comp_first->name, comp_second->name) != 0)
+        if (comp_first->type == CT_NORMAL && comp_first->name != comp_second->name)
             return -FAILURE;
-
-        comp_first = TAILQ_NEXT(comp_first, components);
-        comp_second = TAILQ_NEXT(comp_second, components);
     }
 
-    /* At this point, at least one of the two is NULL. If they aren't both
-     * NULL, they have a different number of components and cannot be equal. */
-    if (comp_first != comp_second) {
-        return -FAILURE;
+    return SUCCESS;
+}
+
+/*
+ * Returns a hash of the entry's specifier, i.e., of its components' types,
+ * binding types and names. Entries which compare equal using
+ * __xcb_xrm_entry_compare have the same hash.
+ *
+ */
+uint32_t __xcb_xrm_entry_hash(xcb_xrm_entry_t *entry) {
+    uint32_t hash = HASH_INIT;
+
+    for (int i = 0; i < entry->num_components; i++) {
+        xcb_xrm_component_t *component = &(entry->components[i]);
+        unsigned char kind = component->type << 1 | component->binding_type;
+
+        hash = hash_bytes(hash, &kind, 1);
+        hash = hash_bytes(hash, &(component->name), sizeof(xcb_xrm_quark_t));
     }
 
-    return SUCCESS;
+    return hash;
 }
 
 /*
@@ -361,17 +460,17 @@ char *__xcb_xrm_entry_to_string(xcb_xrm_entry_t *entry) {
     char *result = NULL;
     char *value_buf;
     char *escaped_value;
-    xcb_xrm_component_t *component;
     bool is_first = true;
 
     assert(entry != NULL);
-    TAILQ_FOREACH(component, &(entry->components), components) {
+    for (int i = 0; i < entry->num_components; i++) {
+        xcb_xrm_component_t *component = &(entry->components[i]);
         char *tmp;
         if (asprintf(&tmp, "%s%s%s", result == NULL ? "" : result,
                 (is_first && component->binding_type == BT_TIGHT)
                     ? ""
                     : (component->binding_type == BT_TIGHT ? "." : "*"),
-                component->type == CT_NORMAL ? component->name : "?") < 0) {
+                component->type == CT_NORMAL ? __xcb_xrm_quark_to_string(component->name) : "?") < 0) {
             FREE(result);
             return NULL;
         }
@@ -395,46 +494,46 @@ char *__xcb_xrm_entry_to_string(xcb_xrm_entry_t *entry) {
 }
 
 /*
- * Copy the entry.
+ * Copy the entry into memory allocated from the given arena. If arena is NULL,
+ * the copy must be freed using xcb_xrm_entry_free.
  *
  */
-xcb_xrm_entry_t *__xcb_xrm_entry_copy(xcb_xrm_entry_t *entry) {
+xcb_xrm_entry_t *__xcb_xrm_entry_copy(xcb_xrm_entry_t *entry, xcb_xrm_arena_t *arena) {
     xcb_xrm_entry_t *copy;
-    xcb_xrm_component_t *component;
+    size_t value_length;
 
     assert(entry != NULL);
 
-    copy = calloc(1, sizeof(struct xcb_xrm_entry_t));
-    if (copy == NULL)
-        return NULL;
+    value_length = (entry->value == NULL) ? 0 : strlen(entry->value);
+    copy = __entry_new(arena, entry->components, entry->num_components, entry->value != NULL, value_length);
+    if (copy != NULL && copy->value != NULL)
+        memcpy(copy->value, entry->value, value_length);
 
-    copy->value = strdup(entry->value);
-    if (copy->value == NULL) {
-        FREE(copy);
-        return NULL;
-    }
+    return copy;
+}
 
-    TAILQ_INIT(&(copy->components));
-    TAILQ_FOREACH(component, &(entry->components), components) {
-        xcb_xrm_component_t *new = calloc(1, sizeof(struct xcb_xrm_component_t));
-        if (new == NULL) {
-            xcb_xrm_entry_free(copy);
-            return NULL;
-        }
+/*
+ * Replaces the value of current with the value of entry, which must have the
+ * same specifier, if it fits into the memory of current. The memory of entry
+ * is returned to the arena if possible.
+ *
+ * @return True if the value was replaced, in which case entry must not be
+ * used anymore.
+ *
+ */
+bool __xcb_xrm_entry_replace_value(xcb_xrm_entry_t *current, xcb_xrm_entry_t *entry, xcb_xrm_arena_t *arena) {
+    size_t value_length;
 
-        new->name = strdup(component->name);
-        if (new->name == NULL) {
-            xcb_xrm_entry_free(copy);
-            FREE(new);
-            return NULL;
-        }
+    if (current->value == NULL || entry->value == NULL)
+        return false;
 
-        new->type = component->type;
-        new->binding_type = component->binding_type;
-        TAILQ_INSERT_TAIL(&(copy->components), new, components);
-    }
+    value_length = strlen(entry->value);
+    if (value_length > strlen(current->value))
+        return false;
 
-    return copy;
+    memcpy(current->value, entry->value, value_length + 1);
+    __xcb_xrm_arena_release(arena, entry, __entry_size(entry->num_components, true, value_length));
+    return true;
 }
 
 /*
@@ -478,23 +577,14 @@ char *__xcb_xrm_entry_escape_value(const char *value) {
 }
 
 /*
- * Frees the given entry.
+ * Frees the given entry. Must not be used for entries allocated from an
+ * arena.
  *
  * @param entry The entry to be freed.
  *
  */
 void xcb_xrm_entry_free(xcb_xrm_entry_t *entry) {
-    if (entry == NULL)
-        return;
-
-    FREE(entry->value);
-    while (!TAILQ_EMPTY(&(entry->components))) {
-        xcb_xrm_component_t *component = TAILQ_FIRST(&(entry->components));
-        FREE(component->name);
-        TAILQ_REMOVE(&(entry->components), component, components);
-        FREE(component);
-    }
-
+    /* The components and the value share the entry's allocation. */
     FREE(entry);
     return;
 }
@@ -31,230 +31,278 @@
 #include "match.h"
 #include "util.h"
 
+/* The ways of matching a single query component, see __match_step. They are
+ * ordered by precedence, so that paths are visited from the best to the
+ * worst:
+ *
+ * Precedence rule #1: Matching components, including '?', outweigh '*'.
+ * Precedence rule #2: Matching name outweighs both matching class and '?'.
+ *                     Matching class outweighs '?'.
+ * Precedence rule #3: A preceding exact match outweighs a preceding '*'.
+ *
+ * The rules are applied from left to right, i.e., the first component in
+ * which two paths differ decides. */
+typedef enum {
+    STEP_TIGHT_NAME = 0,
+    STEP_LOOSE_NAME,
+    STEP_TIGHT_CLASS,
+    STEP_LOOSE_CLASS,
+    STEP_TIGHT_WILDCARD,
+    STEP_LOOSE_WILDCARD,
+    STEP_SKIP,
+    STEP_DONE
+} xcb_xrm_match_step_t;
+
+/** State shared by all steps of a single lookup. */
+typedef struct xcb_xrm_match_context_t {
+    /* The number of components of the query. */
+    int length;
+    /* The components of the name and class queries. classes is NULL if no
+     * class query was given. */
+    xcb_xrm_component_t *names;
+    xcb_xrm_component_t *classes;
+    /* The frames of the walk, one per query component plus one for the end
+     * of the query. */
+    xcb_xrm_match_frame_t *frames;
+    /* Open addressing hash table of the states visited so far. */
+    xcb_xrm_match_state_t *states;
+    /* The number of slots in states. */
+    int states_size;
+    /* The number of used slots in states. */
+    int num_states;
+    /* The matching entry or NULL if none has been found yet. */
+    xcb_xrm_entry_t *best;
+} xcb_xrm_match_context_t;
+
 /* Forward declarations */
-static int __match_matches(int num_components, xcb_xrm_component_t *cur_comp_db,
-        xcb_xrm_component_t *cur_comp_name, xcb_xrm_component_t *cur_comp_class,
-        bool has_class, int position, xcb_xrm_match_ignore_t ignore, xcb_xrm_match_t **match);
-static xcb_xrm_match_flags_t __match_matches_component(xcb_xrm_component_t *comp_db,
-        xcb_xrm_component_t *comp_name, xcb_xrm_component_t *comp_class);
-static int __match_compare(int length, xcb_xrm_match_t *best, xcb_xrm_match_t *candidate);
-static xcb_xrm_match_t *__match_new(int length);
-static void __match_copy(xcb_xrm_match_t *src, xcb_xrm_match_t *dest, int length);
-static void __match_free(xcb_xrm_match_t *match);
+static xcb_xrm_node_t *__match_step(xcb_xrm_match_context_t *context, xcb_xrm_match_frame_t *frame, int position,
+        bool *loose_only);
+static int __match_visit(xcb_xrm_match_context_t *context, xcb_xrm_node_t *node, int position, bool loose_only);
+static uint32_t __match_state_hash(xcb_xrm_node_t *node, int position, bool loose_only);
 
 /*
  * Finds the matching entry in the database given a full name / class query string.
+ * The value of the entry is stored in the resource, or NULL if no entry matches.
+ *
+ * @return 0 on success, a negative error code otherwise.
  *
  */
 int __xcb_xrm_match(xcb_xrm_database_t *database, xcb_xrm_entry_t *query_name, xcb_xrm_entry_t *query_class,
         xcb_xrm_resource_t *resource) {
-    xcb_xrm_match_t *best_match = NULL;
-    xcb_xrm_entry_t *cur_entry = TAILQ_FIRST(database);
-
-    int num = __xcb_xrm_entry_num_components(query_name);
-
-    while (cur_entry != NULL) {
-        xcb_xrm_match_t *cur_match = NULL;
-
-        /* First we check whether the current database entry even matches. */
-        bool has_class = query_class != NULL;
-        xcb_xrm_component_t *first_comp_name = TAILQ_FIRST(&(query_name->components));
-        xcb_xrm_component_t *first_comp_class = has_class ? TAILQ_FIRST(&(query_class->components)) : NULL;
-        xcb_xrm_component_t *first_comp_db = TAILQ_FIRST(&(cur_entry->components));
-        if (__match_matches(num, first_comp_db, first_comp_name, first_comp_class, has_class,
-                    0, MI_UNDECIDED, &cur_match) == 0) {
-            cur_match->entry = cur_entry;
-
-            /* The first matching entry is the first one we pick as the best matching entry. */
-            if (best_match == NULL) {
-                best_match = cur_match;
-            } else {
-                /* Otherwise, check whether this match is better than the current best. */
-                if (__match_compare(num, best_match, cur_match) == 0) {
-                    __match_free(best_match);
-                    best_match = cur_match;
-                } else {
-                    __match_free(cur_match);
-                }
-            }
-        } else {
-            __match_free(cur_match);
-        }
-
-        /* Advance to the next database entry. */
-        cur_entry = TAILQ_NEXT(cur_entry, entries);
-    }
-
-    if (best_match != NULL) {
-        resource->value = strdup(best_match->entry->value);
-        if (resource->value == NULL) {
-            __match_free(best_match);
+    xcb_xrm_match_context_t context = { 0 };
+    xcb_xrm_match_frame_t inline_frames[MATCH_INLINE_LENGTH + 1];
+    xcb_xrm_match_state_t inline_states[MATCH_INLINE_STATES];
+    int result = -FAILURE;
+    int depth;
+
+    context.length = query_name->num_components;
+    context.names = query_name->components;
+    if (query_class != NULL)
+        context.classes = query_class->components;
+
+    /* The scratch space is taken from the stack unless the query is unusually
+     * long or the walk visits more states than fit into inline_states. */
+    context.frames = inline_frames;
+    if (context.length > MATCH_INLINE_LENGTH) {
+        context.frames = calloc(context.length + 1, sizeof(struct xcb_xrm_match_frame_t));
+        if (context.frames == NULL)
             return -FAILURE;
-        }
-
-        __match_free(best_match);
-        return SUCCESS;
     }
 
-    return -FAILURE;
-}
-
-static int __match_matches(int num_components, xcb_xrm_component_t *cur_comp_db,
-        xcb_xrm_component_t *cur_comp_name, xcb_xrm_component_t *cur_comp_class,
-        bool has_class, int position, xcb_xrm_match_ignore_t ignore, xcb_xrm_match_t **match) {
-    xcb_xrm_match_flags_t comp_match;
-
-    if (*match == NULL) {
-        *match = __match_new(num_components);
-        if (*match == NULL)
-            return -FAILURE;
-    }
+    memset(inline_states, 0, sizeof(inline_states));
+    context.states = inline_states;
+    context.states_size = MATCH_INLINE_STATES;
+
+    /* Walk the component tree depth-first, only descending into branches
+     * which match the query.
+     *
+     * Since the children are visited in order of precedence, paths are seen
+     * from the best to the worst. The first entry reached at the end of the
+     * query is therefore the best match and ends the walk. Likewise, the
+     * first visit of any state, i.e., a node at a query position, happens
+     * through the best possible path to it. Any later visit of the same state
+     * has a worse prefix, so everything reachable from it has already been
+     * seen with a better precedence and it can be skipped. This bounds the
+     * walk by the number of nodes times the query length, even for entries
+     * with many loose bindings. */
+    context.frames[0].node = database->root;
+    context.frames[0].loose_only = false;
+    context.frames[0].step = STEP_TIGHT_NAME;
+    depth = 0;
+
+    while (depth >= 0) {
+        xcb_xrm_match_frame_t *frame = &(context.frames[depth]);
+        xcb_xrm_node_t *child;
+        bool loose_only;
+
+        if (depth == context.length) {
+            /* An entry reached by skipping the last component does not match,
+             * since its last binding must still match a component. */
+            if (!frame->loose_only && frame->node->entry != NULL) {
+                context.best = frame->node->entry;
+                break;
+            }
 
-    /* Check if we reached the end of the recursion. */
-    if (cur_comp_name == NULL || (has_class && cur_comp_class == NULL) || cur_comp_db == NULL) {
-        if (cur_comp_db == NULL && cur_comp_name == NULL && (!has_class || cur_comp_class == NULL)) {
-            return SUCCESS;
+            depth--;
+            continue;
         }
 
-        return -FAILURE;
-    }
-
-    comp_match = __match_matches_component(cur_comp_db, cur_comp_name, cur_comp_class);
-
-    /* If we have a matching component in a loose binding, we need to continue
-     * matching both normally and ignoring this match. */
-    if (ignore == MI_UNDECIDED && cur_comp_db->binding_type == BT_LOOSE &&
-            (comp_match & MF_NAME || comp_match & MF_CLASS || comp_match & MF_WILDCARD)) {
-
-        /* Store references / copies to the current parameters for the second call. */
-        xcb_xrm_component_t *copy_comp_db = cur_comp_db;
-        xcb_xrm_component_t *copy_comp_name = cur_comp_name;
-        xcb_xrm_component_t *copy_comp_class = cur_comp_class;
-        xcb_xrm_match_t *copy_match = __match_new(num_components);
-        __match_copy(*match, copy_match, num_components);
-
-        /* First, we try to match normally. */
-        if (__match_matches(num_components, cur_comp_db, cur_comp_name, cur_comp_class, has_class,
-                    position, MI_DO_NOT_IGNORE, match) == 0) {
-            __match_free(copy_match);
-            return SUCCESS;
+        child = __match_step(&context, frame, depth, &loose_only);
+        if (child == NULL) {
+            depth--;
+            continue;
         }
 
-        /* We had no success the first time around, so let's try to reset and
-         * go again, but this time ignoring this match. */
-        __match_free(*match);
-        *match = copy_match;
-        if (__match_matches(num_components, copy_comp_db, copy_comp_name, copy_comp_class, has_class,
-                    position, MI_IGNORE, match) == 0) {
-            return SUCCESS;
+        switch (__match_visit(&context, child, depth + 1, loose_only)) {
+            case 0:
+                break;
+            case 1:
+                continue;
+            default:
+                goto done_match;
         }
 
-        /* Give up. */
-        return -FAILURE;
+        depth++;
+        context.frames[depth].node = child;
+        context.frames[depth].loose_only = loose_only;
+        context.frames[depth].step = STEP_TIGHT_NAME;
     }
 
-    /* Store the match flags on the match so we can use them later for precedence evaluation. */
-    (*match)->flags[position] = comp_match;
-    if (comp_match == MF_NONE)
-        return -FAILURE;
-
-#define ADVANCE(entry) do {                      \
-    if (entry != NULL)                           \
-        entry = TAILQ_NEXT((entry), components); \
-} while (0)
-
-    /* We have matched this component, so advance to the next one. */
-    ADVANCE(cur_comp_name);
-    ADVANCE(cur_comp_class);
-    /* We advance the pointer to the database entry component if both of the following are true:
-     *  1. This match isn't ignored due to a loose binding path.
-     *  2. It was an actual match and not skipped due to a loose binding. */
-    if (ignore != MI_IGNORE &&
-            (comp_match & MF_NAME || comp_match & MF_CLASS || comp_match & MF_WILDCARD)) {
-        ADVANCE(cur_comp_db);
-    }
+    /* The value is owned by the database, so no copy is made here. */
+    resource->value = (context.best == NULL) ? NULL : context.best->value;
+    result = SUCCESS;
 
-#undef ADVANCE
+done_match:
+    if (context.frames != inline_frames)
+        FREE(context.frames);
+    if (context.states != inline_states)
+        FREE(context.states);
 
-    /* Recursively descend to the next component. */
-    return __match_matches(num_components, cur_comp_db, cur_comp_name, cur_comp_class, has_class,
-            position + 1, MI_UNDECIDED, match);
+    return result;
 }
 
-static xcb_xrm_match_flags_t __match_matches_component(xcb_xrm_component_t *comp_db,
-        xcb_xrm_component_t *comp_name, xcb_xrm_component_t *comp_class) {
-    xcb_xrm_match_flags_t result = MF_NONE;
-    if (comp_db->binding_type == BT_LOOSE)
-        result = MF_PRECEDING_LOOSE;
-
-    if (comp_db->type == CT_NORMAL) {
-        if (strcmp(comp_db->name, comp_name->name) == 0) {
-            result |= MF_NAME;
-        } else if (comp_class != NULL && strcmp(comp_db->name, comp_class->name) == 0) {
-            result |= MF_CLASS;
-        } else {
-            if (comp_db->binding_type == BT_TIGHT)
-                return MF_NONE;
-
-            /* We remove this flag again because we need to apply
-             * it to the last component in the matching chain for
-             * the loose binding. */
-            result &= ~MF_PRECEDING_LOOSE;
-            result |= MF_SKIPPED;
+/*
+ * Advances the frame to the next child of its node which matches the query
+ * component at the given position.
+ * Returns NULL if all ways have been tried.
+ *
+ */
+static xcb_xrm_node_t *__match_step(xcb_xrm_match_context_t *context, xcb_xrm_match_frame_t *frame, int position,
+        bool *loose_only) {
+    xcb_xrm_node_t *node = frame->node;
+    xcb_xrm_quark_t name = context->names[position].name;
+    xcb_xrm_quark_t class;
+
+    /* If name and class are the same, the component is matched by its name. */
+    class = (context->classes != NULL && context->classes[position].name != name)
+        ? context->classes[position].name
+        : NULLQUARK;
+
+    *loose_only = false;
+    while (frame->step != STEP_DONE) {
+        xcb_xrm_match_step_t step = frame->step++;
+        xcb_xrm_node_t *child = NULL;
+
+        if (frame->loose_only &&
+                (step == STEP_TIGHT_NAME || step == STEP_TIGHT_CLASS || step == STEP_TIGHT_WILDCARD)) {
+            continue;
+        }
+
+        switch (step) {
+            case STEP_TIGHT_NAME:
+                child = __xcb_xrm_node_find_child(node, BT_TIGHT, name);
+                break;
+            case STEP_LOOSE_NAME:
+                child = __xcb_xrm_node_find_child(node, BT_LOOSE, name);
+                break;
+            case STEP_TIGHT_CLASS:
+                if (class != NULLQUARK)
+                    child = __xcb_xrm_node_find_child(node, BT_TIGHT, class);
+                break;
+            case STEP_LOOSE_CLASS:
+                if (class != NULLQUARK)
+                    child = __xcb_xrm_node_find_child(node, BT_LOOSE, class);
+                break;
+            case STEP_TIGHT_WILDCARD:
+                child = node->tight_wildcard;
+                break;
+            case STEP_LOOSE_WILDCARD:
+                child = node->loose_wildcard;
+                break;
+            case STEP_SKIP:
+                /* A loose binding can also skip the component altogether. */
+                if (__xcb_xrm_node_has_loose_children(node)) {
+                    child = node;
+                    *loose_only = true;
+                }
+                break;
+            default:
+                return NULL;
         }
-    } else {
-        result |= MF_WILDCARD;
+
+        if (child != NULL)
+            return child;
     }
 
-    return result;
+    return NULL;
 }
 
-static int __match_compare(int length, xcb_xrm_match_t *best, xcb_xrm_match_t *candidate) {
-    for (int i = 0; i < length; i++) {
-        xcb_xrm_match_flags_t mt_best = best->flags[i];
-        xcb_xrm_match_flags_t mt_candidate = candidate->flags[i];
+/*
+ * Marks the node as visited at the given query position.
+ * Returns 0 if this is the first visit, 1 if the state has been visited before
+ * and a negative error code otherwise.
+ *
+ */
+static int __match_visit(xcb_xrm_match_context_t *context, xcb_xrm_node_t *node, int position, bool loose_only) {
+    uint32_t mask;
+    uint32_t slot;
+
+    /* Grow the table to keep its load factor below one half. */
+    if (2 * (context->num_states + 1) > context->states_size) {
+        xcb_xrm_match_state_t *old_states = context->states;
+        int old_size = context->states_size;
+        int new_size = old_size * 2;
+        xcb_xrm_match_state_t *states = calloc(new_size, sizeof(struct xcb_xrm_match_state_t));
+        if (states == NULL)
+            return -FAILURE;
 
-        /* Precedence rule #1: Matching components, including '?', outweigh '*'. */
-        if (mt_best & MF_SKIPPED &&
-                (mt_candidate & MF_NAME || mt_candidate & MF_CLASS || mt_candidate & MF_WILDCARD))
-            return SUCCESS;
+        for (int i = 0; i < old_size; i++) {
+            xcb_xrm_match_state_t *state = &(old_states[i]);
+            if (state->node == NULL)
+                continue;
 
-        /* Precedence rule #2: Matching name outweighs both matching class and '?'.
-         *                     Matching class outweighs '?'. */
-        if ((mt_best & MF_CLASS || mt_best & MF_WILDCARD) && mt_candidate & MF_NAME)
-            return SUCCESS;
+            slot = __match_state_hash(state->node, state->position, state->loose_only) & (new_size - 1);
+            while (states[slot].node != NULL)
+                slot = (slot + 1) & (new_size - 1);
+            states[slot] = *state;
+        }
 
-        if (mt_best & MF_WILDCARD && mt_candidate & MF_CLASS)
-            return SUCCESS;
+        /* The initial table lives on the stack of __xcb_xrm_match. */
+        if (old_size != MATCH_INLINE_STATES)
+            FREE(old_states);
 
-        /* Precedence rule #3: A preceding exact match outweighs a preceding '*'. */
-        if (mt_best & MF_PRECEDING_LOOSE && !(mt_candidate & MF_PRECEDING_LOOSE))
-            return SUCCESS;
+        context->states = states;
+        context->states_size = new_size;
     }
 
-    return -FAILURE;
-}
-
-static xcb_xrm_match_t *__match_new(int length) {
-    xcb_xrm_match_t *match = calloc(1, sizeof(struct xcb_xrm_match_t));
-    if (match == NULL)
-        return NULL;
+    mask = context->states_size - 1;
+    slot = __match_state_hash(node, position, loose_only) & mask;
+    while (context->states[slot].node != NULL) {
+        xcb_xrm_match_state_t *state = &(context->states[slot]);
+        if (state->node == node && state->position == position && state->loose_only == loose_only)
+            return 1;
 
-    match->entry = NULL;
-    match->flags = calloc(1, length * sizeof(xcb_xrm_match_flags_t));
-    if (match->flags == NULL) {
-        FREE(match);
-        return NULL;
+        slot = (slot + 1) & mask;
     }
 
-    return match;
-}
-
-static void __match_copy(xcb_xrm_match_t *src, xcb_xrm_match_t *dest, int length) {
-    memcpy(dest->flags, src->flags, length * sizeof(xcb_xrm_match_flags_t));
+    context->states[slot].node = node;
+    context->states[slot].position = position;
+    context->states[slot].loose_only = loose_only;
+    context->num_states++;
+    return 0;
 }
 
-static void __match_free(xcb_xrm_match_t *match) {
-    FREE(match->flags);
-    FREE(match);
+static uint32_t __match_state_hash(xcb_xrm_node_t *node, int position, bool loose_only) {
+    uintptr_t key = (uintptr_t)node ^ ((uintptr_t)position << 1) ^ (uintptr_t)loose_only;
+    return (uint32_t)((key ^ (key >> 17)) * 2654435761u);
 }
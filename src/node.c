@@ -0,0 +1,179 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#include "externals.h"
+
+#include "node.h"
+#include "util.h"
+
+/* Forward declarations */
+static xcb_xrm_node_t *__node_table_find(xcb_xrm_node_table_t *table, xcb_xrm_quark_t name);
+static size_t __node_table_bucket(xcb_xrm_quark_t name, size_t size);
+static int __node_table_insert(xcb_xrm_node_table_t *table, xcb_xrm_node_t *node, xcb_xrm_arena_t *arena);
+
+/*
+ * Creates a new, empty root node allocated from the given arena.
+ *
+ */
+xcb_xrm_node_t *__xcb_xrm_node_new(xcb_xrm_arena_t *arena) {
+    return __xcb_xrm_arena_alloc(arena, sizeof(struct xcb_xrm_node_t));
+}
+
+/*
+ * Stores the entry in the node described by its components, creating any
+ * missing nodes along the way from the given arena. An entry previously stored
+ * in the same node is replaced.
+ *
+ * @return 0 on success, a negative error code otherwise.
+ *
+ */
+int __xcb_xrm_node_insert(xcb_xrm_node_t *root, xcb_xrm_entry_t *entry, xcb_xrm_arena_t *arena) {
+    xcb_xrm_node_t *node = root;
+
+    for (int i = 0; i < entry->num_components; i++) {
+        xcb_xrm_component_t *component = &(entry->components[i]);
+        xcb_xrm_node_t *child;
+        xcb_xrm_node_table_t *table;
+
+        if (component->type == CT_WILDCARD) {
+            xcb_xrm_node_t **wildcard = (component->binding_type == BT_TIGHT)
+                ? &(node->tight_wildcard)
+                : &(node->loose_wildcard);
+
+            if (*wildcard == NULL) {
+                *wildcard = __xcb_xrm_node_new(arena);
+                if (*wildcard == NULL)
+                    return -FAILURE;
+            }
+
+            node = *wildcard;
+            continue;
+        }
+
+        table = (component->binding_type == BT_TIGHT) ? &(node->tight) : &(node->loose);
+
+        child = __node_table_find(table, component->name);
+        if (child == NULL) {
+            child = __xcb_xrm_node_new(arena);
+            if (child == NULL)
+                return -FAILURE;
+
+            child->name = component->name;
+            if (__node_table_insert(table, child, arena) < 0)
+                return -FAILURE;
+        }
+
+        node = child;
+    }
+
+    node->entry = entry;
+    return SUCCESS;
+}
+
+/*
+ * Returns the child of the node reached through the given binding type and
+ * component name or NULL if there is no such child.
+ *
+ */
+xcb_xrm_node_t *__xcb_xrm_node_find_child(xcb_xrm_node_t *node, xcb_xrm_binding_type_t binding_type,
+        xcb_xrm_quark_t name) {
+    xcb_xrm_node_table_t *table = (binding_type == BT_TIGHT) ? &(node->tight) : &(node->loose);
+
+    if (table->count == 0)
+        return NULL;
+
+    return __node_table_find(table, name);
+}
+
+/*
+ * Returns true if the node has any children reached through a loose binding.
+ *
+ */
+bool __xcb_xrm_node_has_loose_children(xcb_xrm_node_t *node) {
+    return node->loose.count > 0 || node->loose_wildcard != NULL;
+}
+
+static xcb_xrm_node_t *__node_table_find(xcb_xrm_node_table_t *table, xcb_xrm_quark_t name) {
+    xcb_xrm_node_t *current;
+
+    if (table->buckets == NULL)
+        return NULL;
+
+    current = table->buckets[__node_table_bucket(name, table->size)];
+    while (current != NULL) {
+        if (current->name == name)
+            return current;
+
+        current = current->next;
+    }
+
+    return NULL;
+}
+
+static int __node_table_insert(xcb_xrm_node_table_t *table, xcb_xrm_node_t *node, xcb_xrm_arena_t *arena) {
+    xcb_xrm_node_t **bucket;
+
+    /* Grow the table once the load factor exceeds one. The old buckets are
+     * left in the arena, which at most doubles the memory used for them. */
+    if (table->count >= table->size) {
+        size_t new_size = table->size == 0 ? NODE_TABLE_INITIAL_SIZE : 2 * table->size;
+        xcb_xrm_node_t **new_buckets = __xcb_xrm_arena_alloc(arena, new_size * sizeof(xcb_xrm_node_t *));
+        if (new_buckets == NULL)
+            return -FAILURE;
+
+        for (size_t i = 0; i < table->size; i++) {
+            xcb_xrm_node_t *current = table->buckets[i];
+            while (current != NULL) {
+                xcb_xrm_node_t *next = current->next;
+
+                bucket = &(new_buckets[__node_table_bucket(current->name, new_size)]);
+                current->next = *bucket;
+                *bucket = current;
+
+                current = next;
+            }
+        }
+
+        table->buckets = new_buckets;
+        table->size = new_size;
+    }
+
+    bucket = &(table->buckets[__node_table_bucket(node->name, table->size)]);
+    node->next = *bucket;
+    *bucket = node;
+    table->count++;
+
+    return SUCCESS;
+}
+
+static size_t __node_table_bucket(xcb_xrm_quark_t name, size_t size) {
+    /* Quarks are assigned sequentially, so spread them using Fibonacci
+     * hashing, i.e., take the high bits of the product. The size is a power
+     * of two of at least NODE_TABLE_INITIAL_SIZE. */
+    return (uint32_t)(name * 2654435761u) >> (32 - __builtin_ctzl(size));
+}
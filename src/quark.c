@@ -0,0 +1,196 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#include "externals.h"
+
+#include "arena.h"
+#include "quark.h"
+#include "util.h"
+
+/* Serializes interning. Lookups of quarks do not take it; they only depend on
+ * quark_table being published with release semantics. */
+static pthread_mutex_t quark_lock = PTHREAD_MUTEX_INITIALIZER;
+/* The memory for the interned strings. */
+static xcb_xrm_arena_t quark_arena = { NULL };
+/* The interned strings, indexed by their quark. Protected by quark_lock. */
+static char **quark_strings = NULL;
+/* The number of allocated elements in quark_strings. */
+static size_t quark_strings_size = 0;
+/* The next quark to be assigned. */
+static xcb_xrm_quark_t quark_next = NULLQUARK + 1;
+/* The current table of quark entries. */
+static xcb_xrm_quark_table_t *quark_table = NULL;
+
+/* Forward declarations */
+static xcb_xrm_quark_entry_t **__quark_find_slot(xcb_xrm_quark_table_t *table,
+        const char *str, size_t length, uint32_t hash);
+static int __quark_grow(void);
+
+/*
+ * Returns the quark for the given string of the given length, interning the
+ * string if necessary. The string does not need to be NUL-terminated.
+ *
+ * @return The quark or NULLQUARK if the string could not be interned.
+ *
+ */
+xcb_xrm_quark_t __xcb_xrm_quark_intern(const char *str, size_t length) {
+    uint32_t hash = hash_bytes(HASH_INIT, str, length);
+    xcb_xrm_quark_entry_t **slot;
+    xcb_xrm_quark_entry_t *entry;
+    xcb_xrm_quark_t quark = NULLQUARK;
+
+    pthread_mutex_lock(&quark_lock);
+
+    /* Keep the load factor of the table below one half. */
+    if ((quark_table == NULL || 2 * quark_next >= quark_table->size) && __quark_grow() < 0)
+        goto done_intern;
+
+    slot = __quark_find_slot(quark_table, str, length, hash);
+    if (*slot != NULL) {
+        quark = (*slot)->quark;
+        goto done_intern;
+    }
+
+    if (quark_next >= quark_strings_size) {
+        size_t new_size = quark_strings_size == 0 ? QUARK_TABLE_INITIAL_SIZE : 2 * quark_strings_size;
+        char **new_strings = realloc(quark_strings, new_size * sizeof(char *));
+        if (new_strings == NULL)
+            goto done_intern;
+
+        quark_strings = new_strings;
+        quark_strings_size = new_size;
+    }
+
+    entry = __xcb_xrm_arena_alloc(&quark_arena, sizeof(xcb_xrm_quark_entry_t) + length + 1);
+    if (entry == NULL)
+        goto done_intern;
+
+    entry->hash = hash;
+    entry->quark = quark_next;
+    memcpy(entry->str, str, length);
+    entry->str[length] = '\0';
+
+    quark = quark_next++;
+    quark_strings[quark] = entry->str;
+
+    /* Publish the fully initialized entry to concurrent readers. */
+    __atomic_store_n(slot, entry, __ATOMIC_RELEASE);
+
+done_intern:
+    pthread_mutex_unlock(&quark_lock);
+    return quark;
+}
+
+/*
+ * Returns the quark for the given string of the given length without interning
+ * it. The string does not need to be NUL-terminated. This does not take
+ * quark_lock, so it can run concurrently with other lookups and interning.
+ *
+ * @return The quark or NULLQUARK if the string has not been interned.
+ *
+ */
+xcb_xrm_quark_t __xcb_xrm_quark_find(const char *str, size_t length) {
+    xcb_xrm_quark_table_t *table = __atomic_load_n(&quark_table, __ATOMIC_ACQUIRE);
+    xcb_xrm_quark_entry_t *entry;
+
+    if (table == NULL)
+        return NULLQUARK;
+
+    entry = __atomic_load_n(__quark_find_slot(table, str, length, hash_bytes(HASH_INIT, str, length)),
+            __ATOMIC_ACQUIRE);
+    return entry == NULL ? NULLQUARK : entry->quark;
+}
+
+/*
+ * Returns the string represented by the given quark. The string must not be
+ * modified or freed.
+ *
+ */
+const char *__xcb_xrm_quark_to_string(xcb_xrm_quark_t quark) {
+    const char *result = NULL;
+
+    pthread_mutex_lock(&quark_lock);
+    if (quark != NULLQUARK && quark < quark_next)
+        result = quark_strings[quark];
+    pthread_mutex_unlock(&quark_lock);
+
+    return result;
+}
+
+/*
+ * Returns the slot of the given table which either contains the entry for the
+ * given string or, if the string has not been interned yet, the empty slot
+ * where it should be inserted. Slots are read with acquire semantics so that
+ * the entries published by __xcb_xrm_quark_intern are fully visible.
+ *
+ */
+static xcb_xrm_quark_entry_t **__quark_find_slot(xcb_xrm_quark_table_t *table,
+        const char *str, size_t length, uint32_t hash) {
+    size_t mask = table->size - 1;
+
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        xcb_xrm_quark_entry_t *entry = __atomic_load_n(&(table->slots[i]), __ATOMIC_ACQUIRE);
+        if (entry == NULL)
+            return &(table->slots[i]);
+
+        if (entry->hash == hash && strncmp(entry->str, str, length) == 0 && entry->str[length] == '\0')
+            return &(table->slots[i]);
+    }
+}
+
+/*
+ * Doubles the size of the table. Must be called with quark_lock held. The old
+ * table is not freed since concurrent readers may still be probing it.
+ *
+ */
+static int __quark_grow(void) {
+    size_t new_size = quark_table == NULL ? QUARK_TABLE_INITIAL_SIZE : 2 * quark_table->size;
+    xcb_xrm_quark_table_t *new_table = calloc(1, sizeof(xcb_xrm_quark_table_t) +
+            new_size * sizeof(xcb_xrm_quark_entry_t *));
+    if (new_table == NULL)
+        return -FAILURE;
+
+    new_table->previous = quark_table;
+    new_table->size = new_size;
+
+    for (size_t j = 0; quark_table != NULL && j < quark_table->size; j++) {
+        xcb_xrm_quark_entry_t *entry = quark_table->slots[j];
+        size_t i;
+        if (entry == NULL)
+            continue;
+
+        i = entry->hash & (new_size - 1);
+        while (new_table->slots[i] != NULL)
+            i = (i + 1) & (new_size - 1);
+
+        new_table->slots[i] = entry;
+    }
+
+    __atomic_store_n(&quark_table, new_table, __ATOMIC_RELEASE);
+    return SUCCESS;
+}
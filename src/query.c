@@ -0,0 +1,297 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#include "externals.h"
+
+#include "query.h"
+#include "scan.h"
+#include "util.h"
+
+/* Forward declarations */
+static char *__query_join(const char **components, int *num_components);
+static int __query_tokenize(const char *str, xcb_xrm_entry_t *entry);
+
+/*
+ * Creates a query for the given resource name and class strings. The query
+ * can be used for any number of lookups on any database and must be free'd
+ * using xcb_xrm_query_free.
+ *
+ * @param res_name The fully qualified resource name string.
+ * @param res_class The fully qualified resource class string. This argument
+ * may be left empty / NULL, but if given, it must contain the same number of
+ * components as res_name.
+ * @returns The query or NULL if the strings could not be parsed.
+ */
+xcb_xrm_query_t *xcb_xrm_query_from_strings(const char *res_name, const char *res_class) {
+    xcb_xrm_query_t *query;
+
+    if (res_name == NULL)
+        return NULL;
+
+    query = calloc(1, sizeof(struct xcb_xrm_query_t));
+    if (query == NULL)
+        return NULL;
+
+    if (xcb_xrm_entry_parse(res_name, &(query->name), true, NULL) < 0)
+        goto done_error;
+
+    /* For the resource class input, we allow NULL and empty string as
+     * placeholders for not specifying this string. Technically this is
+     * violating the spec, but it seems to be widely used. */
+    if (res_class != NULL && strlen(res_class) > 0 &&
+            xcb_xrm_entry_parse(res_class, &(query->class), true, NULL) < 0) {
+        goto done_error;
+    }
+
+    /* We rely on name and class query strings to have the same number of
+     * components, so let's check that this is the case. The specification
+     * backs us up here. */
+    if (query->class != NULL &&
+            query->name->num_components != query->class->num_components) {
+        goto done_error;
+    }
+
+    query->name->hash = __xcb_xrm_entry_hash(query->name);
+    return query;
+
+done_error:
+    xcb_xrm_query_free(query);
+    return NULL;
+}
+
+/*
+ * Creates a query from NULL-terminated arrays of resource name and class
+ * components.
+ *
+ * @param res_name The components of the resource name.
+ * @param res_class The components of the resource class. This argument may be
+ * NULL or empty, but if given, it must contain the same number of components
+ * as res_name.
+ * @returns The query or NULL if a component is not a valid resource name.
+ */
+xcb_xrm_query_t *xcb_xrm_query_from_arrays(const char **res_name, const char **res_class) {
+    xcb_xrm_query_t *query = NULL;
+    char *str_name = NULL;
+    char *str_class = NULL;
+    int num_names;
+    int num_classes = 0;
+
+    if (res_name == NULL)
+        return NULL;
+
+    str_name = __query_join(res_name, &num_names);
+    if (str_name == NULL)
+        goto done_arrays;
+
+    if (res_class != NULL && res_class[0] != NULL) {
+        str_class = __query_join(res_class, &num_classes);
+        if (str_class == NULL)
+            goto done_arrays;
+    }
+
+    query = xcb_xrm_query_from_strings(str_name, str_class);
+    if (query == NULL)
+        goto done_arrays;
+
+    /* A component containing a binding or an empty component would have
+     * changed the number of components, so reject those. */
+    if (query->name->num_components != num_names ||
+            (query->class != NULL && query->class->num_components != num_classes)) {
+        xcb_xrm_query_free(query);
+        query = NULL;
+    }
+
+done_arrays:
+    FREE(str_name);
+    FREE(str_class);
+    return query;
+}
+
+/*
+ * Parses the resource name and class strings into a query stored in the given
+ * buffer without allocating any memory. Unlike xcb_xrm_query_from_strings,
+ * component names are not interned, so the query is only good for lookups on
+ * databases which exist at this point.
+ *
+ * @return The query or NULL if the strings could not be parsed. This includes
+ * strings which are valid but cannot be parsed without allocating, e.g.,
+ * because they have more than QUERY_INLINE_COMPONENTS components.
+ *
+ */
+xcb_xrm_query_t *__xcb_xrm_query_parse(xcb_xrm_query_buffer_t *buffer, const char *res_name,
+        const char *res_class) {
+    xcb_xrm_query_t *query = &(buffer->query);
+
+    if (res_name == NULL)
+        return NULL;
+
+    query->name = &(buffer->name.entry);
+    query->class = NULL;
+
+    if (__query_tokenize(res_name, query->name) < 0)
+        return NULL;
+
+    /* See xcb_xrm_query_from_strings. */
+    if (res_class != NULL && res_class[0] != '\0') {
+        query->class = &(buffer->class.entry);
+        if (__query_tokenize(res_class, query->class) < 0 ||
+                query->name->num_components != query->class->num_components) {
+            return NULL;
+        }
+    }
+
+    query->name->hash = __xcb_xrm_entry_hash(query->name);
+    return query;
+}
+
+/*
+ * Destroys the given query.
+ *
+ * @param query The query to destroy.
+ */
+void xcb_xrm_query_free(xcb_xrm_query_t *query) {
+    if (query == NULL)
+        return;
+
+    xcb_xrm_entry_free(query->name);
+    xcb_xrm_entry_free(query->class);
+    FREE(query);
+}
+
+/*
+ * Returns the name of the query's component at the given position.
+ *
+ */
+xcb_xrm_quark_t __xcb_xrm_query_name(xcb_xrm_query_t *query, int position) {
+    return query->name->components[position].name;
+}
+
+/*
+ * Returns the class of the query's component at the given position or
+ * NULLQUARK if no class was given or it is the same as the name.
+ *
+ */
+xcb_xrm_quark_t __xcb_xrm_query_class(xcb_xrm_query_t *query, int position) {
+    /* A class which is the same as the name does not add anything. */
+    if (query->class == NULL || query->class->components[position].name == __xcb_xrm_query_name(query, position))
+        return NULLQUARK;
+
+    return query->class->components[position].name;
+}
+
+/*
+ * Joins the given NULL-terminated array of components into a resource string
+ * using tight bindings.
+ *
+ */
+static char *__query_join(const char **components, int *num_components) {
+    char *result;
+    char *walk;
+    size_t length = 0;
+    int i;
+
+    for (i = 0; components[i] != NULL; i++) {
+        length += strlen(components[i]) + 1;
+    }
+
+    *num_components = i;
+    if (i == 0)
+        return NULL;
+
+    result = malloc(length);
+    if (result == NULL)
+        return NULL;
+
+    walk = result;
+    for (i = 0; components[i] != NULL; i++) {
+        size_t component_length = strlen(components[i]);
+
+        if (i > 0)
+            *(walk++) = '.';
+        memcpy(walk, components[i], component_length);
+        walk += component_length;
+    }
+    *walk = '\0';
+
+    return result;
+}
+
+/*
+ * Splits the given resource string into the components of the given entry,
+ * which has room for QUERY_INLINE_COMPONENTS components. This accepts the
+ * same strings as xcb_xrm_entry_parse with resource_only set, except for
+ * names containing whitespace, which would have to be copied to be joined.
+ * Names which have never been interned cannot match any entry and are
+ * represented by NULLQUARK.
+ *
+ * @return 0 on success, a negative error code otherwise.
+ *
+ */
+static int __query_tokenize(const char *str, xcb_xrm_entry_t *entry) {
+    size_t length = strlen(str);
+    size_t pos = 0;
+    bool separated = true;
+
+    entry->value = NULL;
+    entry->num_components = 0;
+
+    while (pos < length) {
+        xcb_xrm_component_t *component;
+        size_t end;
+
+        if (str[pos] == '.') {
+            separated = true;
+            pos++;
+            continue;
+        }
+
+        if (str[pos] == ' ' || str[pos] == '\t') {
+            pos++;
+            continue;
+        }
+
+        /* This rejects loose bindings, wildcards and anything else which is
+         * not allowed in a resource name. */
+        end = __xcb_xrm_scan_name(str, pos, length);
+        if (end == pos)
+            return -FAILURE;
+
+        if (!separated || entry->num_components == QUERY_INLINE_COMPONENTS)
+            return -FAILURE;
+
+        component = &(entry->components[entry->num_components++]);
+        component->name = __xcb_xrm_quark_find(str + pos, end - pos);
+        component->type = CT_NORMAL;
+        component->binding_type = BT_TIGHT;
+
+        separated = false;
+        pos = end;
+    }
+
+    return (entry->num_components == 0) ? -FAILURE : SUCCESS;
+}
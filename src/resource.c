@@ -31,12 +31,23 @@
 #include "resource.h"
 #include "database.h"
 #include "match.h"
+#include "query.h"
+#include "search.h"
 #include "util.h"
 
+/** A query of a batch lookup along with its position in the batch. */
+typedef struct xcb_xrm_batch_item_t {
+    xcb_xrm_query_t *query;
+    int index;
+} xcb_xrm_batch_item_t;
+
 /* Forward declarations */
-static int __resource_get(xcb_xrm_database_t *database, const char *res_name, const char *res_class,
-                         xcb_xrm_resource_t **_resource);
-static void __resource_free(xcb_xrm_resource_t *resource);
+static xcb_xrm_query_t *__resource_query(xcb_xrm_query_buffer_t *buffer, const char *res_name,
+        const char *res_class, xcb_xrm_query_t **allocated);
+static int __resource_get(xcb_xrm_database_t *database, xcb_xrm_query_t *query,
+                         xcb_xrm_resource_t *resource);
+static int __batch_compare(const void *a, const void *b);
+static int __batch_common_prefix(xcb_xrm_query_t *first, xcb_xrm_query_t *second);
 
 /*
  * Find the string value of a resource.
@@ -53,18 +64,52 @@ static void __resource_free(xcb_xrm_resource_t *resource);
  */
 int xcb_xrm_resource_get_string(xcb_xrm_database_t *database,
         const char *res_name, const char *res_class, char **out) {
-    xcb_xrm_resource_t *resource;
-    if (__resource_get(database, res_name, res_class, &resource) < 0) {
-        __resource_free(resource);
+    xcb_xrm_query_buffer_t buffer;
+    xcb_xrm_query_t *allocated;
+    xcb_xrm_query_t *query;
+    int result;
+
+    query = __resource_query(&buffer, res_name, res_class, &allocated);
+    if (query == NULL) {
         *out = NULL;
         return -1;
     }
 
-    assert(resource->value != NULL);
-    *out = strdup(resource->value);
-    __resource_free(resource);
+    result = xcb_xrm_resource_get_string_query(database, query, out);
+    xcb_xrm_query_free(allocated);
+    return result;
+}
 
-    return 0;
+/*
+ * Find the string value of a resource without copying it.
+ *
+ * The returned string is owned by the database and must not be modified or
+ * free'd. It is only valid until the database is modified or free'd.
+ *
+ * @param database The database to query.
+ * @param res_name The fully qualified resource name string.
+ * @param res_class The fully qualified resource class string. This argument
+ * may be left empty / NULL, but if given, it must contain the same number of
+ * components as res_name.
+ * @param out Out parameter to which the value will be written.
+ * @returns 0 if the resource was found, a negative error code otherwise.
+ */
+int xcb_xrm_resource_get_string_ref(xcb_xrm_database_t *database,
+        const char *res_name, const char *res_class, const char **out) {
+    xcb_xrm_query_buffer_t buffer;
+    xcb_xrm_query_t *allocated;
+    xcb_xrm_query_t *query;
+    int result;
+
+    query = __resource_query(&buffer, res_name, res_class, &allocated);
+    if (query == NULL) {
+        *out = NULL;
+        return -1;
+    }
+
+    result = xcb_xrm_resource_get_string_ref_query(database, query, out);
+    xcb_xrm_query_free(allocated);
+    return result;
 }
 
 /*
@@ -81,20 +126,20 @@ int xcb_xrm_resource_get_string(xcb_xrm_database_t *database,
  */
 int xcb_xrm_resource_get_long(xcb_xrm_database_t *database,
         const char *res_name, const char *res_class, long *out) {
-    char *value;
-    if (xcb_xrm_resource_get_string(database, res_name, res_class, &value) < 0 || value == NULL) {
-        *out = LONG_MIN;
-        return -2;
-    }
+    xcb_xrm_query_buffer_t buffer;
+    xcb_xrm_query_t *allocated;
+    xcb_xrm_query_t *query;
+    int result;
 
-    if (str2long(out, value, 10) < 0) {
+    query = __resource_query(&buffer, res_name, res_class, &allocated);
+    if (query == NULL) {
         *out = LONG_MIN;
-        FREE(value);
-        return -1;
+        return -2;
     }
 
-    FREE(value);
-    return 0;
+    result = xcb_xrm_resource_get_long_query(database, query, out);
+    xcb_xrm_query_free(allocated);
+    return result;
 }
 
 /*
@@ -119,17 +164,121 @@ int xcb_xrm_resource_get_long(xcb_xrm_database_t *database,
  */
 int xcb_xrm_resource_get_bool(xcb_xrm_database_t *database,
         const char *res_name, const char *res_class, bool *out) {
-    char *value;
+    xcb_xrm_query_buffer_t buffer;
+    xcb_xrm_query_t *allocated;
+    xcb_xrm_query_t *query;
+    int result;
+
+    query = __resource_query(&buffer, res_name, res_class, &allocated);
+    if (query == NULL) {
+        *out = false;
+        return -2;
+    }
+
+    result = xcb_xrm_resource_get_bool_query(database, query, out);
+    xcb_xrm_query_free(allocated);
+    return result;
+}
+
+/*
+ * Find the string value of a resource using a query created by, e.g.,
+ * xcb_xrm_query_from_strings.
+ *
+ * Note that the string is owned by the caller and must be free'd.
+ *
+ * @param database The database to query.
+ * @param query The resource to look up.
+ * @param out Out parameter to which the value will be written.
+ * @returns 0 if the resource was found, a negative error code otherwise.
+ */
+int xcb_xrm_resource_get_string_query(xcb_xrm_database_t *database,
+        xcb_xrm_query_t *query, char **out) {
+    const char *value;
+    if (xcb_xrm_resource_get_string_ref_query(database, query, &value) < 0) {
+        *out = NULL;
+        return -1;
+    }
+
+    *out = strdup(value);
+    if (*out == NULL)
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Find the string value of a resource using a query without copying it.
+ *
+ * The returned string is owned by the database and must not be modified or
+ * free'd. It is only valid until the database is modified or free'd.
+ *
+ * @param database The database to query.
+ * @param query The resource to look up.
+ * @param out Out parameter to which the value will be written.
+ * @returns 0 if the resource was found, a negative error code otherwise.
+ */
+int xcb_xrm_resource_get_string_ref_query(xcb_xrm_database_t *database,
+        xcb_xrm_query_t *query, const char **out) {
+    xcb_xrm_resource_t resource = { NULL };
+    if (__resource_get(database, query, &resource) < 0) {
+        *out = NULL;
+        return -1;
+    }
+
+    assert(resource.value != NULL);
+    *out = resource.value;
+
+    return 0;
+}
+
+/*
+ * Find the long value of a resource using a query. See
+ * xcb_xrm_resource_get_long for details on the conversion.
+ *
+ * @param database The database to query.
+ * @param query The resource to look up.
+ * @param out Out parameter to which the converted value will be written.
+ * @returns 0 if the resource was found and converted, -1 if the resource was
+ * found but could not be converted and -2 if the resource was not found.
+ */
+int xcb_xrm_resource_get_long_query(xcb_xrm_database_t *database,
+        xcb_xrm_query_t *query, long *out) {
+    const char *value;
+    if (xcb_xrm_resource_get_string_ref_query(database, query, &value) < 0 || value == NULL) {
+        *out = LONG_MIN;
+        return -2;
+    }
+
+    if (str2long(out, value, 10) < 0) {
+        *out = LONG_MIN;
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Find the bool value of a resource using a query. See
+ * xcb_xrm_resource_get_bool for details on the conversion.
+ *
+ * @param database The database to query.
+ * @param query The resource to look up.
+ * @param out Out parameter to which the converted value will be written.
+ * @returns 0 if the resource was found and converted, -1 if the resource was
+ * found but could not be converted and -2 if the resource was not found.
+ */
+int xcb_xrm_resource_get_bool_query(xcb_xrm_database_t *database,
+        xcb_xrm_query_t *query, bool *out) {
+    const char *value;
     long converted;
 
-    if (xcb_xrm_resource_get_string(database, res_name, res_class, &value) < 0 || value == NULL) {
+    if (xcb_xrm_resource_get_string_ref_query(database, query, &value) < 0 || value == NULL) {
         *out = false;
         return -2;
     }
 
     /* Let's first see if the value can be parsed into an integer directly. */
     if (str2long(&converted, value, 10) == 0) {
-        FREE(value);
         *out = converted;
         return 0;
     }
@@ -138,7 +287,6 @@ int xcb_xrm_resource_get_bool(xcb_xrm_database_t *database,
     if (strcasecmp(value, "true") == 0 ||
             strcasecmp(value, "on") == 0 ||
             strcasecmp(value, "yes") == 0) {
-        FREE(value);
         *out = true;
         return 0;
     }
@@ -146,69 +294,225 @@ int xcb_xrm_resource_get_bool(xcb_xrm_database_t *database,
     if (strcasecmp(value, "false") == 0 ||
             strcasecmp(value, "off") == 0 ||
             strcasecmp(value, "no") == 0) {
-        FREE(value);
         *out = false;
         return 0;
     }
 
-    FREE(value);
     *out = false;
     return -1;
 }
 
-static int __resource_get(xcb_xrm_database_t *database, const char *res_name, const char *res_class,
-                         xcb_xrm_resource_t **_resource) {
-    xcb_xrm_resource_t *resource;
-    xcb_xrm_entry_t *query_name = NULL;
-    xcb_xrm_entry_t *query_class = NULL;
-    int result = SUCCESS;
+/*
+ * Find the string values of several resources at once without copying them.
+ *
+ * The queries are evaluated together so that queries sharing a common prefix,
+ * e.g., all attributes of one widget, only match this prefix against the
+ * database once.
+ *
+ * Note that the strings are owned by the database and must not be modified or
+ * free'd. They are only valid until the database is modified or free'd.
+ *
+ * @param database The database to query.
+ * @param queries The resources to look up. NULL elements are ignored.
+ * @param num_queries The number of queries.
+ * @param values Array of num_queries elements to which the values will be
+ * written. For every resource which was not found, NULL is written.
+ * @returns The number of resources found or a negative error code.
+ */
+int xcb_xrm_resource_get_batch(xcb_xrm_database_t *database, xcb_xrm_query_t **queries, int num_queries,
+        const char **values) {
+    xcb_xrm_batch_item_t *items = NULL;
+    xcb_xrm_search_level_t *levels = NULL;
+    xcb_xrm_query_t *previous = NULL;
+    xcb_xrm_entry_t *exact;
+    int num_items = 0;
+    int max_length = 0;
+    int num_levels;
+    int found = 0;
+    int result = -FAILURE;
 
-    if (database == NULL || TAILQ_EMPTY(database)) {
-        *_resource = NULL;
-        return -FAILURE;
+    for (int i = 0; i < num_queries; i++) {
+        values[i] = NULL;
     }
 
-    *_resource = calloc(1, sizeof(struct xcb_xrm_resource_t));
-    if (_resource == NULL) {
-        result = -FAILURE;
-        goto done;
+    if (database == NULL || num_queries <= 0 || TAILQ_EMPTY(&(database->entries)))
+        return 0;
+
+    items = calloc(num_queries, sizeof(struct xcb_xrm_batch_item_t));
+    if (items == NULL)
+        goto done_batch;
+
+    for (int i = 0; i < num_queries; i++) {
+        if (queries[i] == NULL || !__xcb_xrm_database_filter_test(database, queries[i]))
+            continue;
+
+        exact = __xcb_xrm_database_find_exact(database, queries[i]);
+        if (exact != NULL) {
+            values[i] = exact->value;
+            found++;
+            continue;
+        }
+
+        items[num_items].query = queries[i];
+        items[num_items].index = i;
+        num_items++;
+
+        max_length = MAX(max_length, queries[i]->name->num_components);
     }
-    resource = *_resource;
 
-    if (res_name == NULL || xcb_xrm_entry_parse(res_name, &query_name, true) < 0) {
-        result = -FAILURE;
-        goto done;
+    if (num_items == 0) {
+        result = found;
+        goto done_batch;
     }
 
-    /* For the resource class input, we allow NULL and empty string as
-     * placeholders for not specifying this string. Technically this is
-     * violating the spec, but it seems to be widely used. */
-    if (res_class != NULL && strlen(res_class) > 0 &&
-            xcb_xrm_entry_parse(res_class, &query_class, true) < 0) {
-        result = -1;
-        goto done;
+    /* Sorting the queries puts queries with a common prefix next to each
+     * other. */
+    qsort(items, num_items, sizeof(struct xcb_xrm_batch_item_t), __batch_compare);
+
+    /* levels[i] holds the states reached by the first i components of the
+     * current query. */
+    levels = calloc(max_length, sizeof(struct xcb_xrm_search_level_t));
+    if (levels == NULL)
+        goto done_batch;
+
+    if (__xcb_xrm_search_level_init(&(levels[0]), database->root) < 0)
+        goto done_batch;
+    num_levels = 1;
+
+    for (int i = 0; i < num_items; i++) {
+        xcb_xrm_query_t *query = items[i].query;
+        int length = query->name->num_components;
+        xcb_xrm_entry_t *entry;
+
+        /* The levels of the previous query can be reused as far as both
+         * queries share the same prefix. */
+        if (previous != NULL)
+            num_levels = MIN(num_levels, __batch_common_prefix(previous, query) + 1);
+
+        for (; num_levels < length; num_levels++) {
+            if (__xcb_xrm_search_level_expand(&(levels[num_levels - 1]), &(levels[num_levels]),
+                        __xcb_xrm_query_name(query, num_levels - 1),
+                        __xcb_xrm_query_class(query, num_levels - 1)) < 0) {
+                goto done_batch;
+            }
+        }
+
+        entry = __xcb_xrm_search_level_resolve(&(levels[length - 1]),
+                __xcb_xrm_query_name(query, length - 1), __xcb_xrm_query_class(query, length - 1));
+        if (entry != NULL) {
+            values[items[i].index] = entry->value;
+            found++;
+        }
+
+        previous = query;
     }
 
-    /* We rely on name and class query strings to have the same number of
-     * components, so let's check that this is the case. The specification
-     * backs us up here. */
-    if (query_class != NULL &&
-            __xcb_xrm_entry_num_components(query_name) != __xcb_xrm_entry_num_components(query_class)) {
-        result = -1;
-        goto done;
+    result = found;
+
+done_batch:
+    if (result < 0) {
+        for (int i = 0; i < num_queries; i++) {
+            values[i] = NULL;
+        }
     }
 
-    result = __xcb_xrm_match(database, query_name, query_class, resource);
-done:
-    xcb_xrm_entry_free(query_name);
-    xcb_xrm_entry_free(query_class);
+    if (levels != NULL) {
+        for (int i = 0; i < max_length; i++) {
+            __xcb_xrm_search_level_free(&(levels[i]));
+        }
+    }
+
+    FREE(levels);
+    FREE(items);
     return result;
 }
 
-static void __resource_free(xcb_xrm_resource_t *resource) {
-    if (resource == NULL)
-        return;
+/*
+ * Parses the strings of a single lookup into the given buffer. Only if that is
+ * not possible is the query allocated, in which case it is also returned in
+ * allocated and must be free'd by the caller.
+ *
+ */
+static xcb_xrm_query_t *__resource_query(xcb_xrm_query_buffer_t *buffer, const char *res_name,
+        const char *res_class, xcb_xrm_query_t **allocated) {
+    xcb_xrm_query_t *query;
+
+    *allocated = NULL;
+
+    query = __xcb_xrm_query_parse(buffer, res_name, res_class);
+    if (query == NULL)
+        query = *allocated = xcb_xrm_query_from_strings(res_name, res_class);
+
+    return query;
+}
+
+static int __resource_get(xcb_xrm_database_t *database, xcb_xrm_query_t *query,
+                         xcb_xrm_resource_t *resource) {
+    xcb_xrm_entry_t *exact;
+
+    if (database == NULL || query == NULL || TAILQ_EMPTY(&(database->entries)))
+        return -FAILURE;
+
+    /* Most lookups are for resources which are not set at all. Those can
+     * usually be rejected without walking the tree. */
+    if (!__xcb_xrm_database_filter_test(database, query))
+        return -FAILURE;
+
+    /* Fully qualified entries are common and win over everything else. */
+    exact = __xcb_xrm_database_find_exact(database, query);
+    if (exact != NULL) {
+        resource->value = exact->value;
+        return SUCCESS;
+    }
+
+    if (database->cache != NULL &&
+            __xcb_xrm_cache_find(database->cache, database->generation, query, &(resource->value))) {
+        return resource->value == NULL ? -FAILURE : SUCCESS;
+    }
+
+    if (__xcb_xrm_match(database, query->name, query->class, resource) < 0)
+        return -FAILURE;
+
+    /* Mismatches are cached as well. */
+    if (database->cache != NULL)
+        __xcb_xrm_cache_store(database->cache, database->generation, query, resource->value);
+
+    return resource->value == NULL ? -FAILURE : SUCCESS;
+}
+
+/*
+ * Orders batch items by the name and class of their components.
+ *
+ */
+static int __batch_compare(const void *a, const void *b) {
+    xcb_xrm_query_t *first = ((const xcb_xrm_batch_item_t *)a)->query;
+    xcb_xrm_query_t *second = ((const xcb_xrm_batch_item_t *)b)->query;
+    int common = __batch_common_prefix(first, second);
+
+    if (common < first->name->num_components && common < second->name->num_components) {
+        if (__xcb_xrm_query_name(first, common) != __xcb_xrm_query_name(second, common))
+            return __xcb_xrm_query_name(first, common) < __xcb_xrm_query_name(second, common) ? -1 : 1;
+
+        return __xcb_xrm_query_class(first, common) < __xcb_xrm_query_class(second, common) ? -1 : 1;
+    }
+
+    return first->name->num_components - second->name->num_components;
+}
+
+/*
+ * Returns the number of leading components in which both queries agree.
+ *
+ */
+static int __batch_common_prefix(xcb_xrm_query_t *first, xcb_xrm_query_t *second) {
+    int length = MIN(first->name->num_components, second->name->num_components);
+    int i;
+
+    for (i = 0; i < length; i++) {
+        if (__xcb_xrm_query_name(first, i) != __xcb_xrm_query_name(second, i) ||
+                __xcb_xrm_query_class(first, i) != __xcb_xrm_query_class(second, i)) {
+            break;
+        }
+    }
 
-    FREE(resource->value);
-    FREE(resource);
+    return i;
 }
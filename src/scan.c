@@ -0,0 +1,158 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#include "externals.h"
+
+#include "scan.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_SSE2
+#endif
+
+#if defined(SCAN_SSE2) && defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define SCAN_AVX2
+#endif
+
+/* An implementation of __xcb_xrm_scan_name. */
+typedef size_t (*scan_name_fn_t)(const char *str, size_t pos, size_t length);
+
+static size_t __scan_name_resolve(const char *str, size_t pos, size_t length);
+static size_t __scan_name_scalar(const char *str, size_t pos, size_t length);
+#ifdef SCAN_SSE2
+static size_t __scan_name_sse2(const char *str, size_t pos, size_t length);
+#endif
+#ifdef SCAN_AVX2
+static size_t __scan_name_avx2(const char *str, size_t pos, size_t length);
+#endif
+
+/* The implementation used by __xcb_xrm_scan_name. */
+static scan_name_fn_t scan_name_impl = __scan_name_resolve;
+
+/*
+ * Returns the position of the first character at or after pos which may not
+ * appear in a component name or length if there is none. On x86, the string
+ * is examined in blocks of 16 or, if the CPU supports AVX2, 32 bytes at a time.
+ * No byte at or after length is ever read.
+ *
+ */
+size_t __xcb_xrm_scan_name(const char *str, size_t pos, size_t length) {
+    return __atomic_load_n(&scan_name_impl, __ATOMIC_RELAXED)(str, pos, length);
+}
+
+/*
+ * Picks the implementation for this CPU when the first name is scanned, so
+ * that the CPU does not need to be checked again on later calls. Threads
+ * racing here pick the same implementation.
+ *
+ */
+static size_t __scan_name_resolve(const char *str, size_t pos, size_t length) {
+    scan_name_fn_t impl;
+
+#if defined(SCAN_AVX2)
+    impl = __builtin_cpu_supports("avx2") ? __scan_name_avx2 : __scan_name_sse2;
+#elif defined(SCAN_SSE2)
+    impl = __scan_name_sse2;
+#else
+    impl = __scan_name_scalar;
+#endif
+
+    __atomic_store_n(&scan_name_impl, impl, __ATOMIC_RELAXED);
+    return impl(str, pos, length);
+}
+
+static size_t __scan_name_scalar(const char *str, size_t pos, size_t length) {
+    while (pos < length && __xcb_xrm_scan_is_name_char(str[pos]))
+        pos++;
+
+    return pos;
+}
+
+#ifdef SCAN_SSE2
+/* Returns a bit mask of the bytes in the block which may appear in a component
+ * name. The comparisons are signed, so bytes with the high bit set never pass
+ * them. Setting bit 5 folds upper case letters onto lower case ones without
+ * moving any other character into the range of letters. */
+static inline unsigned int __scan_name_mask_sse2(__m128i block) {
+    __m128i folded = _mm_or_si128(block, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+            _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)),
+            _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+    __m128i other = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('_')),
+            _mm_cmpeq_epi8(block, _mm_set1_epi8('-')));
+
+    return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), other));
+}
+
+static size_t __scan_name_sse2(const char *str, size_t pos, size_t length) {
+    while (pos + 16 <= length) {
+        unsigned int stop = ~__scan_name_mask_sse2(_mm_loadu_si128((const __m128i *)(str + pos))) & 0xffff;
+        if (stop != 0)
+            return pos + __builtin_ctz(stop);
+
+        pos += 16;
+    }
+
+    return __scan_name_scalar(str, pos, length);
+}
+#endif
+
+#ifdef SCAN_AVX2
+/* See __scan_name_mask_sse2. */
+__attribute__((target("avx2")))
+static inline unsigned int __scan_name_mask_avx2(__m256i block) {
+    __m256i folded = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+    __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('0' - 1)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), block));
+    __m256i other = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('_')),
+            _mm256_cmpeq_epi8(block, _mm256_set1_epi8('-')));
+
+    return _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), other));
+}
+
+__attribute__((target("avx2")))
+static size_t __scan_name_avx2(const char *str, size_t pos, size_t length) {
+    while (pos + 32 <= length) {
+        unsigned int stop = ~__scan_name_mask_avx2(_mm256_loadu_si256((const __m256i *)(str + pos)));
+        if (stop != 0)
+            return pos + __builtin_ctz(stop);
+
+        pos += 32;
+    }
+
+    /* The compiler does not reliably clear the upper halves of the AVX
+     * registers before this tail call, which would slow down SSE code run
+     * afterwards. */
+    _mm256_zeroupper();
+    return __scan_name_sse2(str, pos, length);
+}
+#endif
@@ -0,0 +1,337 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * Copyright © 2016 Ingo Bürk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Except as contained in this notice, the names of the authors or their
+ * institutions shall not be used in advertising or otherwise to promote the
+ * sale, use or other dealings in this Software without prior written
+ * authorization from the authors.
+ *
+ */
+#include "externals.h"
+
+#include "search.h"
+#include "database.h"
+#include "query.h"
+#include "util.h"
+
+/* The maximum number of children a state can lead to for one component:
+ * name, class and '?', each through a tight and a loose binding. */
+#define SEARCH_MAX_CANDIDATES 6
+
+/* Forward declarations */
+static int __search_candidates(xcb_xrm_search_state_t *state, xcb_xrm_quark_t name, xcb_xrm_quark_t class,
+        xcb_xrm_node_t **candidates);
+static int __search_push(xcb_xrm_search_level_t *level, xcb_xrm_node_t *node, bool loose_only);
+static int __search_unique(xcb_xrm_search_level_t *level);
+
+/*
+ * Creates a search list for the given prefix.
+ *
+ * The search list refers to the database, so it is only valid until the
+ * database is modified or free'd.
+ *
+ * @param database The database to search.
+ * @param prefix The resource name / class prefix. If NULL, resources are
+ * resolved from the top level of the database.
+ * @returns The search list or NULL if it could not be created.
+ */
+xcb_xrm_search_list_t *xcb_xrm_search_list_new(xcb_xrm_database_t *database, xcb_xrm_query_t *prefix) {
+    xcb_xrm_search_list_t *search_list;
+    xcb_xrm_search_level_t next = { NULL, 0, 0 };
+
+    if (database == NULL)
+        return NULL;
+
+    search_list = calloc(1, sizeof(struct xcb_xrm_search_list_t));
+    if (search_list == NULL)
+        return NULL;
+
+    if (__xcb_xrm_search_level_init(&(search_list->level), database->root) < 0)
+        goto done_error;
+
+    if (prefix != NULL) {
+        for (int i = 0; i < prefix->name->num_components; i++) {
+            xcb_xrm_search_level_t tmp;
+
+            if (__xcb_xrm_search_level_expand(&(search_list->level), &next,
+                        __xcb_xrm_query_name(prefix, i), __xcb_xrm_query_class(prefix, i)) < 0) {
+                goto done_error;
+            }
+
+            tmp = search_list->level;
+            search_list->level = next;
+            next = tmp;
+        }
+    }
+
+    __xcb_xrm_search_level_free(&next);
+    return search_list;
+
+done_error:
+    __xcb_xrm_search_level_free(&next);
+    xcb_xrm_search_list_free(search_list);
+    return NULL;
+}
+
+/*
+ * Find the string value of a resource below the prefix of the search list
+ * without copying it. The result is the same as looking up the prefix and the
+ * query combined into one resource name / class.
+ *
+ * Note that the string is owned by the database and must not be modified or
+ * free'd. It is only valid until the database is modified or free'd.
+ *
+ * @param search_list The search list to resolve the query against.
+ * @param query The rest of the resource.
+ * @param out Out parameter to which the value will be written.
+ * @returns 0 if the resource was found, a negative error code otherwise.
+ */
+int xcb_xrm_search_list_get_string_ref(xcb_xrm_search_list_t *search_list, xcb_xrm_query_t *query,
+        const char **out) {
+    xcb_xrm_search_level_t levels[2] = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+    xcb_xrm_search_level_t *level;
+    xcb_xrm_entry_t *entry = NULL;
+    int length;
+
+    *out = NULL;
+    if (search_list == NULL || query == NULL)
+        return -FAILURE;
+
+    /* Any components before the last one extend the prefix. */
+    level = &(search_list->level);
+    length = query->name->num_components;
+    for (int i = 0; i < length - 1; i++) {
+        xcb_xrm_search_level_t *next = &(levels[i % 2]);
+
+        if (__xcb_xrm_search_level_expand(level, next,
+                    __xcb_xrm_query_name(query, i), __xcb_xrm_query_class(query, i)) < 0) {
+            goto done_get;
+        }
+
+        level = next;
+    }
+
+    entry = __xcb_xrm_search_level_resolve(level,
+            __xcb_xrm_query_name(query, length - 1), __xcb_xrm_query_class(query, length - 1));
+
+done_get:
+    __xcb_xrm_search_level_free(&(levels[0]));
+    __xcb_xrm_search_level_free(&(levels[1]));
+
+    if (entry == NULL)
+        return -FAILURE;
+
+    *out = entry->value;
+    return SUCCESS;
+}
+
+/*
+ * Destroys the given search list.
+ *
+ * @param search_list The search list to destroy.
+ */
+void xcb_xrm_search_list_free(xcb_xrm_search_list_t *search_list) {
+    if (search_list == NULL)
+        return;
+
+    __xcb_xrm_search_level_free(&(search_list->level));
+    FREE(search_list);
+}
+
+/*
+ * Resets the level to only contain the root node of the component tree.
+ *
+ * @return 0 on success, a negative error code otherwise.
+ *
+ */
+int __xcb_xrm_search_level_init(xcb_xrm_search_level_t *level, xcb_xrm_node_t *root) {
+    level->num_states = 0;
+    return __search_push(level, root, false);
+}
+
+/*
+ * Computes the states reached from the given level by matching one more query
+ * component with the given name and class. The class may be NULLQUARK if no
+ * class was given. Any previous contents of next are replaced.
+ *
+ * @return 0 on success, a negative error code otherwise.
+ *
+ */
+int __xcb_xrm_search_level_expand(xcb_xrm_search_level_t *level, xcb_xrm_search_level_t *next,
+        xcb_xrm_quark_t name, xcb_xrm_quark_t class) {
+    next->num_states = 0;
+
+    /* The states of the level are ordered by precedence and the candidates of
+     * each state are as well, so appending them in this order keeps the next
+     * level ordered. */
+    for (int i = 0; i < level->num_states; i++) {
+        xcb_xrm_search_state_t *state = &(level->states[i]);
+        xcb_xrm_node_t *candidates[SEARCH_MAX_CANDIDATES];
+        int num_candidates = __search_candidates(state, name, class, candidates);
+
+        for (int j = 0; j < num_candidates; j++) {
+            if (__search_push(next, candidates[j], false) < 0)
+                return -FAILURE;
+        }
+
+        /* Skipping the component by a loose binding has the lowest precedence. */
+        if (__xcb_xrm_node_has_loose_children(state->node) &&
+                __search_push(next, state->node, true) < 0) {
+            return -FAILURE;
+        }
+    }
+
+    return __search_unique(next);
+}
+
+/*
+ * Returns the entry matching the final query component with the given name and
+ * class from the given level or NULL if there is none.
+ *
+ */
+xcb_xrm_entry_t *__xcb_xrm_search_level_resolve(xcb_xrm_search_level_t *level,
+        xcb_xrm_quark_t name, xcb_xrm_quark_t class) {
+    for (int i = 0; i < level->num_states; i++) {
+        xcb_xrm_node_t *candidates[SEARCH_MAX_CANDIDATES];
+        int num_candidates = __search_candidates(&(level->states[i]), name, class, candidates);
+
+        /* The final component cannot be skipped, so the first candidate
+         * holding an entry is the best match. */
+        for (int j = 0; j < num_candidates; j++) {
+            if (candidates[j]->entry != NULL)
+                return candidates[j]->entry;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Frees the states of the given level.
+ *
+ */
+void __xcb_xrm_search_level_free(xcb_xrm_search_level_t *level) {
+    FREE(level->states);
+    level->num_states = 0;
+    level->size = 0;
+}
+
+/*
+ * Collects the children of the state's node which match the component with the
+ * given name and class, ordered by precedence.
+ *
+ */
+static int __search_candidates(xcb_xrm_search_state_t *state, xcb_xrm_quark_t name, xcb_xrm_quark_t class,
+        xcb_xrm_node_t **candidates) {
+    xcb_xrm_node_t *node = state->node;
+    xcb_xrm_node_t *found[SEARCH_MAX_CANDIDATES];
+    int num_candidates = 0;
+
+    /* If name and class are the same, the component is matched by its name. */
+    if (class == name)
+        class = NULLQUARK;
+
+    /* Precedence rules #2 and #3: name before class before '?', and for each
+     * of them a tight binding before a loose one. */
+    found[0] = state->loose_only ? NULL : __xcb_xrm_node_find_child(node, BT_TIGHT, name);
+    found[1] = __xcb_xrm_node_find_child(node, BT_LOOSE, name);
+    found[2] = (state->loose_only || class == NULLQUARK) ? NULL : __xcb_xrm_node_find_child(node, BT_TIGHT, class);
+    found[3] = (class == NULLQUARK) ? NULL : __xcb_xrm_node_find_child(node, BT_LOOSE, class);
+    found[4] = state->loose_only ? NULL : node->tight_wildcard;
+    found[5] = node->loose_wildcard;
+
+    for (int i = 0; i < SEARCH_MAX_CANDIDATES; i++) {
+        if (found[i] != NULL)
+            candidates[num_candidates++] = found[i];
+    }
+
+    return num_candidates;
+}
+
+/*
+ * Removes all but the first occurrence of every state from the level. A state
+ * reached again later in the level was reached through a worse prefix, so it
+ * cannot lead to a better match. Without this, entries with many loose
+ * bindings make the number of states grow exponentially with the query length.
+ *
+ */
+static int __search_unique(xcb_xrm_search_level_t *level) {
+    xcb_xrm_search_state_t **table;
+    size_t size = 4;
+    int num_unique = 0;
+
+    if (level->num_states < 2)
+        return SUCCESS;
+
+    while (size < 2 * (size_t)level->num_states)
+        size *= 2;
+
+    table = calloc(size, sizeof(xcb_xrm_search_state_t *));
+    if (table == NULL)
+        return -FAILURE;
+
+    for (int i = 0; i < level->num_states; i++) {
+        xcb_xrm_search_state_t *state = &(level->states[i]);
+        uintptr_t key = (uintptr_t)state->node ^ (uintptr_t)state->loose_only;
+        size_t slot = ((key ^ (key >> 17)) * 2654435761u) & (size - 1);
+        bool duplicate = false;
+
+        while (table[slot] != NULL) {
+            if (table[slot]->node == state->node && table[slot]->loose_only == state->loose_only) {
+                duplicate = true;
+                break;
+            }
+
+            slot = (slot + 1) & (size - 1);
+        }
+
+        if (duplicate)
+            continue;
+
+        /* States are only ever moved towards the front, so the table keeps
+         * pointing to the right elements. */
+        level->states[num_unique] = *state;
+        table[slot] = &(level->states[num_unique]);
+        num_unique++;
+    }
+
+    level->num_states = num_unique;
+    FREE(table);
+    return SUCCESS;
+}
+
+static int __search_push(xcb_xrm_search_level_t *level, xcb_xrm_node_t *node, bool loose_only) {
+    if (level->num_states == level->size) {
+        int new_size = level->size == 0 ? SEARCH_LEVEL_INITIAL_SIZE : level->size * 2;
+        xcb_xrm_search_state_t *states = realloc(level->states, new_size * sizeof(struct xcb_xrm_search_state_t));
+        if (states == NULL)
+            return -FAILURE;
+
+        level->states = states;
+        level->size = new_size;
+    }
+
+    level->states[level->num_states].node = node;
+    level->states[level->num_states].loose_only = loose_only;
+    level->num_states++;
+    return SUCCESS;
+}
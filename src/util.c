@@ -50,6 +50,22 @@ int str2long(long *out, const char *input, const int base) {
     return SUCCESS;
 }
 
+/*
+ * Continues the FNV-1a hash with the given data. Pass HASH_INIT to start a new
+ * hash.
+ *
+ */
+uint32_t hash_bytes(uint32_t hash, const void *data, size_t length) {
+    const unsigned char *walk = data;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= walk[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
 char *get_home_dir_file(const char *filename) {
     char *result;
 
@@ -83,47 +99,85 @@ char *resolve_path(const char *path, const char *_base) {
     return result;
 }
 
-char *file_get_contents(const char *filename) {
-    FILE *file;
+/*
+ * Loads the contents of the given file by reading it until its end, which
+ * also works for files whose size is not known up front, e.g., pipes. The
+ * contents are not NUL-terminated and must be released using
+ * file_free_contents.
+ *
+ */
+int file_get_contents(const char *filename, file_contents_t *contents) {
     struct stat stbuf;
-    size_t file_size;
-    char *content;
+    size_t size;
+    int fd;
 
-    if ((file = fopen(filename, "rb")) == NULL)
-        return NULL;
+    contents->data = NULL;
+    contents->length = 0;
 
-    /* We want to read the file in one go, so figure out the file size. */
-    if (fstat(fileno(file), &stbuf) < 0) {
-        fclose(file);
-        return NULL;
+    if ((fd = open(filename, O_RDONLY | O_CLOEXEC)) < 0)
+        return -FAILURE;
+
+    if (fstat(fd, &stbuf) < 0) {
+        close(fd);
+        return -FAILURE;
     }
-    file_size = stbuf.st_size;
 
-    /* Read the file content. */
-    content = calloc(file_size + 1, 1);
-    if (content == NULL) {
-        fclose(file);
-        return NULL;
+    /* The size is only a hint since it is not known for pipes and may change
+     * while reading. */
+    size = (S_ISREG(stbuf.st_mode) && stbuf.st_size > 0) ? (size_t)stbuf.st_size + 1 : 4096;
+    contents->data = malloc(size);
+    if (contents->data == NULL) {
+        close(fd);
+        return -FAILURE;
     }
 
-    if (fread(content, 1, file_size, file) != file_size) {
-        FREE(content);
-        fclose(file);
-        return NULL;
+    while (true) {
+        ssize_t bytes;
+
+        if (contents->length == size) {
+            char *data = realloc(contents->data, size * 2);
+            if (data == NULL)
+                goto done_error;
+
+            contents->data = data;
+            size *= 2;
+        }
+
+        bytes = read(fd, contents->data + contents->length, size - contents->length);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes < 0)
+            goto done_error;
+        if (bytes == 0)
+            break;
+
+        contents->length += bytes;
     }
 
-    fclose(file);
-    content[file_size] = '\0';
-    return content;
+    close(fd);
+    return SUCCESS;
+
+done_error:
+    close(fd);
+    FREE(contents->data);
+    contents->length = 0;
+    return -FAILURE;
 }
 
-char *xcb_util_get_property(xcb_connection_t *conn, xcb_window_t window, xcb_atom_t atom,
+/*
+ * Releases the contents of a file loaded using file_get_contents.
+ *
+ */
+void file_free_contents(file_contents_t *contents) {
+    FREE(contents->data);
+    contents->length = 0;
+}
+
+xcb_get_property_reply_t *xcb_util_get_property(xcb_connection_t *conn, xcb_window_t window, xcb_atom_t atom,
         xcb_atom_t type, size_t size) {
     xcb_get_property_cookie_t cookie;
     xcb_get_property_reply_t *reply;
     xcb_generic_error_t *err;
-    int reply_length;
-    char *content;
 
     cookie = xcb_get_property(conn, 0, window, atom, type, 0, size);
     reply = xcb_get_property_reply(conn, cookie, &err);
@@ -132,7 +186,7 @@ char *xcb_util_get_property(xcb_connection_t *conn, xcb_window_t window, xcb_ato
         return NULL;
     }
 
-    if (reply == NULL || (reply_length = xcb_get_property_value_length(reply)) == 0) {
+    if (reply == NULL || xcb_get_property_value_length(reply) == 0) {
         FREE(reply);
         return NULL;
     }
@@ -143,11 +197,5 @@ char *xcb_util_get_property(xcb_connection_t *conn, xcb_window_t window, xcb_ato
         return xcb_util_get_property(conn, window, atom, type, adjusted_size);
     }
 
-    if (asprintf(&content, "%.*s", reply_length, (char *)xcb_get_property_value(reply)) < 0) {
-        FREE(reply);
-        return NULL;
-    }
-
-    FREE(reply);
-    return content;
+    return reply;
 }
@@ -27,6 +27,7 @@
 #include <stdbool.h>
 #include <stdarg.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <xcb/xcb.h>
 #include <xcb/xcb_aux.h>
@@ -36,6 +37,7 @@
 /* Forward declarations */
 static int test_put_resource(void);
 static int test_combine_databases(void);
+static int test_from_buffer(void);
 static int test_from_file(void);
 static void setup(void);
 static void cleanup(void);
@@ -49,6 +51,7 @@ int main(void) {
     setup();
     err |= test_put_resource();
     err |= test_combine_databases();
+    err |= test_from_buffer();
     err |= test_from_file();
     cleanup();
 
@@ -134,6 +137,45 @@ static int test_combine_databases(void) {
     xcb_xrm_database_free(source_db);
     xcb_xrm_database_free(target_db);
 
+    source_db = xcb_xrm_database_from_string(
+            "a1.?.b1: 1\n"
+            "a2*?.b2: 2\n");
+    target_db = xcb_xrm_database_from_string(
+            "a2*?.b2: 0\n"
+            "a1*?.b1: 0\n");
+    xcb_xrm_database_combine(source_db, &target_db, true);
+    err |= check_database(target_db,
+            "a1*?.b1: 0\n"
+            "a1.?.b1: 1\n"
+            "a2*?.b2: 2\n");
+    xcb_xrm_database_free(source_db);
+    xcb_xrm_database_free(target_db);
+
+    return err;
+}
+
+static int test_from_buffer(void) {
+    bool err = false;
+    const char buffer[] = "First: 1\nSecond*third: 2\\\n3\nFourth: 4";
+    xcb_xrm_database_t *database;
+
+    /* The buffer is not terminated after the second entry. */
+    database = xcb_xrm_database_from_buffer(buffer, strlen("First: 1\nSecond*third: 2\\\n3"));
+    err |= check_database(database,
+            "First: 1\n"
+            "Second*third: 23\n");
+    xcb_xrm_database_free(database);
+
+    /* Parsing stops at a NUL byte. */
+    database = xcb_xrm_database_from_buffer("First: 1\0Second: 2\n", 20);
+    err |= check_database(database,
+            "First: 1\n");
+    xcb_xrm_database_free(database);
+
+    database = xcb_xrm_database_from_buffer(buffer, 0);
+    err |= check_ints(true, database != NULL, "Expected an empty database, but got NULL\n");
+    xcb_xrm_database_free(database);
+
     return err;
 }
 
@@ -149,6 +191,7 @@ static int test_from_file(void) {
     xcb_xrm_database_t *database;
     char *path;
     const char *srcdir;
+    int fds[2];
 
     /* Set by automake, needed for out-of-tree builds */
     srcdir = getenv("srcdir");
@@ -165,6 +208,17 @@ static int test_from_file(void) {
             "Second: 2\n");
     xcb_xrm_database_free(database);
 
+    /* Test that included entries override preceding ones and are overridden
+     * by succeeding ones */
+    asprintf(&path, "%s/tests/resources/4/override.xresources", srcdir);
+    database = xcb_xrm_database_from_file(path);
+    free(path);
+    err |= check_database(database,
+            "First: 2\n"
+            "Third: 3\n"
+            "Second: 3\n");
+    xcb_xrm_database_free(database);
+
     /* Test that the inclusion depth is limited */
     asprintf(&path, "%s/tests/resources/3/loop.xresources", srcdir);
     database = xcb_xrm_database_from_file(path);
@@ -174,6 +228,24 @@ static int test_from_file(void) {
             "Second: 2\n");
     xcb_xrm_database_free(database);
 
+    /* Test xcb_xrm_database_from_file on a pipe, whose size is not known up front */
+    if (pipe(fds) == 0) {
+        const char *content = "First: 1\n*Second: 2\n";
+
+        if (write(fds[1], content, strlen(content)) != (ssize_t)strlen(content))
+            err = true;
+        close(fds[1]);
+
+        asprintf(&path, "/dev/fd/%d", fds[0]);
+        database = xcb_xrm_database_from_file(path);
+        free(path);
+        close(fds[0]);
+        err |= check_database(database,
+                "First: 1\n"
+                "*Second: 2\n");
+        xcb_xrm_database_free(database);
+    }
+
     /* Test xcb_xrm_database_from_default for resolution of $HOME. */
     set_env_var_to_path("HOME", srcdir, "tests/resources/2");
     set_env_var_to_path("XENVIRONMENT", srcdir, "tests/resources/2/xenvironment");
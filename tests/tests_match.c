@@ -29,19 +29,32 @@
 #include <string.h>
 #include <limits.h>
 
+/* We need this to inspect the filter of a database. Both this and Xlib define
+ * NULLQUARK as 0. */
+#include "database.h"
+#include "query.h"
+#undef NULLQUARK
+
 #include <X11/Xresource.h>
 
 #include "tests_utils.h"
 
 /* Forward declarations */
 static int test_get_resource(void);
+static int test_filter_false_positives(void);
 static int test_convert(void);
+static int test_query(void);
+static int test_batch(void);
+static int test_cache(void);
 static void setup(void);
 static void cleanup(void);
 
 static char *check_get_resource_xlib(const char *str_database, const char *res_name, const char *res_class);
 static int check_get_resource(const char *database, const char *res_name, const char *res_class, const char *value,
         bool expected_xlib_mismatch);
+static int check_get_resource_query(xcb_xrm_database_t *database, xcb_xrm_query_t *query, const char *value);
+static int check_get_resource_search_list(xcb_xrm_database_t *database, const char *res_name, const char *res_class,
+        const char *value);
 static int check_convert_to_long(const char *value, const long expected, int expected_return_code);
 static int check_convert_to_bool(const char *value, const bool expected, int expected_return_code);
 
@@ -53,6 +66,10 @@ int main(void) {
     cleanup();
 
     err |= test_convert();
+    err |= test_query();
+    err |= test_batch();
+    err |= test_cache();
+    err |= test_filter_false_positives();
 
     return err;
 }
@@ -106,6 +123,18 @@ static int test_get_resource(void) {
     err |= check_get_resource("First.second.third: 1", "First.third.third", "first.second.fourth", "1", false);
     err |= check_get_resource("First*third*fifth: 1", "First.second.third.fourth.third.fifth", "", "1", false);
     err |= check_get_resource("First: x\\\ny", "First", "", "xy", false);
+    err |= check_get_resource("Fi\\\nrst: x", "First", "", "x", true);
+    err |= check_get_resource("Fi\\\nr\\\nst.sec\\\nond: x", "First.second", "", "x", true);
+    err |= check_get_resource("Abcdefghij\\\nabcdefghij\\\nabcdefghijabcdefghijabcdefghijabcdefghijabcdefghij: x",
+            "Abcdefghijabcdefghijabcdefghijabcdefghijabcdefghijabcdefghijabcdefghij", "", "x", true);
+    err |= check_get_resource("First: x\\\n\\\ny\nSecond: z", "First", "", "xy", false);
+    err |= check_get_resource("First: \\\n x", "First", "", "x", false);
+    err |= check_get_resource("First: \\1\\\n01", "First", "", "A", true);
+    /* Xlib keeps whitespace in the names of a query. */
+    err |= check_get_resource("First.second: 1", " First . second ", "", "1", true);
+    err |= check_get_resource("First.second: 1", "First.sec ond", "", "1", true);
+    err |= check_get_resource("*seventeenth: 1", "a.b.c.d.e.f.g.h.i.j.k.l.m.n.o.p.seventeenth",
+            "A.B.C.D.E.F.G.H.I.J.K.L.M.N.O.P.Seventeenth", "1", false);
     err |= check_get_resource("! First: x", "First", "", NULL, false);
     err |= check_get_resource("# First: x", "First", "", NULL, false);
     err |= check_get_resource("First:", "First", "", "", false);
@@ -190,6 +219,94 @@ static int test_get_resource(void) {
             "First*second: 2\n"
             "First.second: 1\n",
             "First.second", "", "1", false);
+    /* The rules are applied from left to right. */
+    err |= check_get_resource(
+            "First.Second: 1\n"
+            "Third.fourth: 2\n",
+            "first.fourth", "Third.Second", "2", false);
+    err |= check_get_resource(
+            "Third.fourth: 2\n"
+            "First.Second: 1\n",
+            "first.fourth", "Third.Second", "2", false);
+    err |= check_get_resource(
+            "*Second.third: 1\n"
+            "*Third: 2\n",
+            "first.second.third", "First.Second.Third", "1", false);
+    err |= check_get_resource(
+            "*Third: 2\n"
+            "*Second.third: 1\n",
+            "first.second.third", "First.Second.Third", "1", false);
+    /* A component skipped by a loose binding does not count as a match, even
+     * if it would have matched. */
+    err |= check_get_resource(
+            "*first: 1\n"
+            "*?.Third: 2\n",
+            "first.second.first", "First.Second.Third", "2", false);
+    err |= check_get_resource(
+            "*?.Third: 2\n"
+            "*first: 1\n",
+            "first.second.first", "First.Second.Third", "2", false);
+    /* Fully qualified entries */
+    err |= check_get_resource(
+            "xterm*faceSize: 1\n"
+            "XTerm.vt100.faceSize: 2\n"
+            "xterm.vt100.faceSize: 3\n",
+            "xterm.vt100.faceSize", "XTerm.VT100.FaceSize", "3", false);
+    err |= check_get_resource(
+            "xterm*faceSize: 1\n"
+            "XTerm.vt100.faceSize: 2\n"
+            "xterm.vt100.faceSize: 3\n",
+            "xterm.vt100.faceName", "XTerm.VT100.FaceSize", NULL, false);
+    err |= check_get_resource(
+            "xterm.vt100.faceSize: 3\n"
+            "xterm*faceSize: 1\n",
+            "xterm.vt100", "XTerm.VT100", NULL, false);
+    /* The final component may match on either the name or the class. */
+    err |= check_get_resource(
+            "*foreground: 1\n"
+            "*Background: 2\n",
+            "xterm.vt100.background", "XTerm.VT100.Background", "2", false);
+    err |= check_get_resource(
+            "*foreground: 1\n"
+            "*Background: 2\n",
+            "xterm.vt100.cursorColor", "XTerm.VT100.Foreground", NULL, false);
+    /* The best match is found regardless of how many weaker matches precede
+     * it in the database. */
+    err |= check_get_resource(
+            "*: 1\n"
+            "*?: 2\n"
+            "*?.?.?: 3\n"
+            "*Third: 4\n"
+            "*second*third: 5\n"
+            "?.second.Third: 6\n"
+            "First.second.Third: 7\n",
+            "first.second.third", "First.Second.Third", "7", false);
+    err |= check_get_resource(
+            "?.second.Third: 6\n"
+            "*second*third: 5\n"
+            "*Third: 4\n"
+            "*?.?.?: 3\n",
+            "first.second.third", "First.Second.Third", "6", false);
+    /* Queries with many components */
+    err |= check_get_resource(
+            "a*b*c*d: 1\n"
+            "a.?.?*d: 2\n",
+            "a.b.c.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.d",
+            "", "1", false);
+    err |= check_get_resource(
+            "a*b*c*d: 1\n"
+            "a.?.?*d: 2\n",
+            "a.x.c.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.d",
+            "", "2", false);
+    /* Many loose bindings */
+    err |= check_get_resource(
+            "*a*a*a*a*a*b: 1\n"
+            "*a*a*a*a*a*a*a*c: 2\n",
+            "a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.c", "", "2", false);
+    err |= check_get_resource(
+            "*a*a*a*a*a*b: 1\n"
+            "*a*a*a*a*a*a*a*c: 2\n",
+            "a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.d", "", NULL, false);
 
     /* Some real world examples. May contain duplicates to the above tests. */
 
@@ -215,6 +332,45 @@ static int test_get_resource(void) {
     return err;
 }
 
+static int test_filter_false_positives(void) {
+    bool err = false;
+    xcb_xrm_database_t *database = NULL;
+    xcb_xrm_query_t *query;
+    xcb_xrm_quark_t name;
+    int false_positives = 0;
+    char buffer[64];
+
+    fprintf(stderr, "== Assert that names passing the filter by chance do not match\n");
+    for (int i = 0; i < 2048; i++) {
+        snprintf(buffer, sizeof(buffer), "Filter.fill%d", i);
+        xcb_xrm_database_put_resource(&database, buffer, "fill");
+    }
+
+    for (int i = 0; i < 1024; i++) {
+        snprintf(buffer, sizeof(buffer), "Filter.probe%d", i);
+        query = xcb_xrm_query_from_strings(buffer, NULL);
+        name = query->name->components[1].name;
+
+        if (__xcb_xrm_database_filter_contains(database, name)) {
+            false_positives++;
+            err |= check_get_resource_query(database, query, NULL);
+        }
+
+        xcb_xrm_query_free(query);
+    }
+
+    err |= check_ints(1, false_positives > 0, "No name passed the filter by chance\n");
+    /* The filter grows with the database, so only a few names pass it. */
+    err |= check_ints(1, false_positives < 1024 / 10, "Too many names passed the filter by chance\n");
+
+    query = xcb_xrm_query_from_strings("Filter.fill42", NULL);
+    err |= check_get_resource_query(database, query, "fill");
+    xcb_xrm_query_free(query);
+
+    xcb_xrm_database_free(database);
+    return err;
+}
+
 static int test_convert(void) {
     bool err = false;
 
@@ -247,6 +403,178 @@ static int test_convert(void) {
     return err;
 }
 
+static int test_query(void) {
+    bool err = false;
+    xcb_xrm_database_t *first = xcb_xrm_database_from_string(
+            "First*third: 1\n"
+            "First.second.third: 2\n");
+    xcb_xrm_database_t *second = xcb_xrm_database_from_string(
+            "*Third: 3\n");
+    xcb_xrm_query_t *query;
+    int result;
+    const char *ref_value;
+    long long_value;
+    bool bool_value;
+
+    const char *names[] = { "First", "second", "third", NULL };
+    const char *classes[] = { "First", "Second", "Third", NULL };
+    const char *short_classes[] = { "First", "Second", NULL };
+    const char *invalid_names[] = { "First", "second.third", NULL };
+    const char *empty_names[] = { "First", "", "third", NULL };
+    const char *no_names[] = { NULL };
+
+    fprintf(stderr, "== Assert that a query can be used on multiple databases\n");
+    query = xcb_xrm_query_from_strings("First.second.third", "First.Second.Third");
+    err |= check_get_resource_query(first, query, "2");
+    err |= check_get_resource_query(second, query, "3");
+    err |= check_get_resource_query(first, query, "2");
+    err |= check_get_resource_query(NULL, query, NULL);
+    err |= check_ints(0, xcb_xrm_resource_get_string_ref(first, "First.second.third", NULL, &ref_value),
+            "Expected a reference to be returned\n");
+    err |= check_strings("2", ref_value, "Expected <2>, but found <%s>\n", ref_value);
+    err |= check_ints(-1, xcb_xrm_resource_get_string_ref(first, "First.second", NULL, &ref_value),
+            "Expected no reference to be returned\n");
+    err |= check_strings(NULL, ref_value, "Expected NULL, but found <%s>\n", ref_value);
+    result = xcb_xrm_resource_get_long_query(second, query, &long_value);
+    err |= check_ints(0, result, "Expected <%d>, but found <%d>\n", 0, result);
+    err |= check_longs(3, long_value, "Expected <%ld>, but found <%ld>\n", 3L, long_value);
+    result = xcb_xrm_resource_get_bool_query(first, query, &bool_value);
+    err |= check_ints(0, result, "Expected <%d>, but found <%d>\n", 0, result);
+    err |= check_ints(true, bool_value, "Expected <%d>, but found <%d>\n", true, bool_value);
+    xcb_xrm_query_free(query);
+
+    fprintf(stderr, "== Assert that a query can be created from arrays\n");
+    query = xcb_xrm_query_from_arrays(names, classes);
+    err |= check_get_resource_query(first, query, "2");
+    err |= check_get_resource_query(second, query, "3");
+    xcb_xrm_query_free(query);
+
+    query = xcb_xrm_query_from_arrays(names, NULL);
+    err |= check_get_resource_query(first, query, "2");
+    err |= check_get_resource_query(second, query, NULL);
+    xcb_xrm_query_free(query);
+
+    fprintf(stderr, "== Assert that invalid queries are rejected\n");
+    err |= check_ints(true, xcb_xrm_query_from_strings(NULL, NULL) == NULL, "Expected NULL query\n");
+    err |= check_ints(true, xcb_xrm_query_from_strings("First*second", NULL) == NULL, "Expected NULL query\n");
+    err |= check_ints(true, xcb_xrm_query_from_strings("First.second", "First") == NULL, "Expected NULL query\n");
+    err |= check_ints(true, xcb_xrm_query_from_arrays(names, short_classes) == NULL, "Expected NULL query\n");
+    err |= check_ints(true, xcb_xrm_query_from_arrays(invalid_names, NULL) == NULL, "Expected NULL query\n");
+    err |= check_ints(true, xcb_xrm_query_from_arrays(empty_names, NULL) == NULL, "Expected NULL query\n");
+    err |= check_ints(true, xcb_xrm_query_from_arrays(no_names, NULL) == NULL, "Expected NULL query\n");
+
+    fprintf(stderr, "== Assert that names which were never used before can be looked up\n");
+    err |= check_ints(0, xcb_xrm_resource_get_string_ref(second, "Unheardof.unknown.name", "Unheardof.Unknown.Third",
+                &ref_value), "Expected a reference to be returned\n");
+    err |= check_strings("3", ref_value, "Expected <3>, but found <%s>\n", ref_value);
+    err |= check_ints(0, xcb_xrm_resource_get_string_ref(first, "First.unheardof.third", "First.Unheardof.Third",
+                &ref_value), "Expected a reference to be returned\n");
+    err |= check_strings("1", ref_value, "Expected <1>, but found <%s>\n", ref_value);
+    err |= check_ints(-1, xcb_xrm_resource_get_string_ref(first, "First.second.unheardof", "First.Second.Third",
+                &ref_value), "Expected no reference to be returned\n");
+    err |= check_ints(-1, xcb_xrm_resource_get_string_ref(second, "Unheardof", "Unknown", &ref_value),
+            "Expected no reference to be returned\n");
+
+    xcb_xrm_database_free(first);
+    xcb_xrm_database_free(second);
+    return err;
+}
+
+static int test_batch(void) {
+    bool err = false;
+    xcb_xrm_database_t *database = xcb_xrm_database_from_string(
+            "*background: black\n"
+            "Widget*Button.background: gray\n"
+            "Widget.box.button.foreground: white\n"
+            "Widget.box*Font: fixed\n"
+            "Widget.?.label: text\n");
+    const char *expected[] = { "gray", "white", "fixed", NULL, "black", NULL, "text", "black" };
+    const char *values[8];
+    xcb_xrm_query_t *queries[8];
+    int found;
+
+    fprintf(stderr, "== Assert that a batch of queries returns the same values as single queries\n");
+    queries[0] = xcb_xrm_query_from_strings("Widget.box.button.background", "Widget.Box.Button.Background");
+    queries[1] = xcb_xrm_query_from_strings("Widget.box.button.foreground", "Widget.Box.Button.Foreground");
+    queries[2] = xcb_xrm_query_from_strings("Widget.box.button.font", "Widget.Box.Button.Font");
+    queries[3] = xcb_xrm_query_from_strings("Widget.box.button.border", "Widget.Box.Button.Border");
+    queries[4] = xcb_xrm_query_from_strings("Widget.box.background", "Widget.Box.Background");
+    queries[5] = NULL;
+    queries[6] = xcb_xrm_query_from_strings("Widget.box.label", NULL);
+    queries[7] = xcb_xrm_query_from_strings("Widget.box.button.background", NULL);
+
+    found = xcb_xrm_resource_get_batch(database, queries, 8, values);
+    err |= check_ints(6, found, "Expected <%d> resources to be found, but found <%d>\n", 6, found);
+    for (int i = 0; i < 8; i++) {
+        const char *single = NULL;
+
+        err |= check_strings(expected[i], values[i], "Expected <%s>, but batch returned <%s>\n",
+                expected[i], values[i]);
+
+        if (queries[i] != NULL)
+            xcb_xrm_resource_get_string_ref_query(database, queries[i], &single);
+        err |= check_strings(single, values[i], "Single query returned <%s>, but batch returned <%s>\n",
+                single, values[i]);
+
+        xcb_xrm_query_free(queries[i]);
+    }
+
+    fprintf(stderr, "== Assert that a batch on an empty database finds nothing\n");
+    queries[0] = xcb_xrm_query_from_strings("Widget", NULL);
+    found = xcb_xrm_resource_get_batch(NULL, queries, 1, values);
+    err |= check_ints(0, found, "Expected <%d> resources to be found, but found <%d>\n", 0, found);
+    err |= check_strings(NULL, values[0], "Expected NULL, but found <%s>\n", values[0]);
+    xcb_xrm_query_free(queries[0]);
+
+    fprintf(stderr, "== Assert that an empty batch finds nothing\n");
+    found = xcb_xrm_resource_get_batch(database, queries, 0, values);
+    err |= check_ints(0, found, "Expected <%d> resources to be found, but found <%d>\n", 0, found);
+
+    xcb_xrm_database_free(database);
+    return err;
+}
+
+static int test_cache(void) {
+    bool err = false;
+    xcb_xrm_database_t *database = xcb_xrm_database_from_string("*background: black\n");
+    xcb_xrm_database_t *source;
+    xcb_xrm_query_t *query = xcb_xrm_query_from_strings("Widget.background", "Widget.Background");
+
+    fprintf(stderr, "== Assert that cached lookups are invalidated when the database changes\n");
+    err |= check_ints(0, xcb_xrm_database_enable_cache(database, true), "Failed to enable the cache\n");
+    err |= check_get_resource_query(database, query, "black");
+    err |= check_get_resource_query(database, query, "black");
+
+    xcb_xrm_database_put_resource(&database, "Widget.background", "white");
+    err |= check_get_resource_query(database, query, "white");
+    err |= check_get_resource_query(database, query, "white");
+
+    xcb_xrm_database_put_resource_line(&database, "Widget.background: gray");
+    err |= check_get_resource_query(database, query, "gray");
+
+    source = xcb_xrm_database_from_string("Widget.background: red\n");
+    xcb_xrm_database_combine(source, &database, false);
+    err |= check_get_resource_query(database, query, "gray");
+    xcb_xrm_database_combine(source, &database, true);
+    err |= check_get_resource_query(database, query, "red");
+    xcb_xrm_database_free(source);
+    xcb_xrm_query_free(query);
+
+    fprintf(stderr, "== Assert that cached mismatches are invalidated when the database changes\n");
+    query = xcb_xrm_query_from_strings("Widget.foreground", NULL);
+    err |= check_get_resource_query(database, query, NULL);
+    err |= check_get_resource_query(database, query, NULL);
+    xcb_xrm_database_put_resource(&database, "*foreground", "blue");
+    err |= check_get_resource_query(database, query, "blue");
+
+    err |= check_ints(0, xcb_xrm_database_enable_cache(database, false), "Failed to disable the cache\n");
+    err |= check_get_resource_query(database, query, "blue");
+    xcb_xrm_query_free(query);
+
+    xcb_xrm_database_free(database);
+    return err;
+}
+
 static char *check_get_resource_xlib(const char *str_database, const char *res_name, const char *res_class) {
     int res_code;
     char *res_type;
@@ -269,6 +597,7 @@ static char *check_get_resource_xlib(const char *str_database, const char *res_n
 static int check_get_resource(const char *str_database, const char *res_name, const char *res_class, const char *value,
         bool expected_xlib_mismatch) {
     xcb_xrm_database_t *database;
+    xcb_xrm_query_t *query;
 
     bool err = false;
     char *xcb_value;
@@ -278,6 +607,16 @@ static int check_get_resource(const char *str_database, const char *res_name, co
             res_name, res_class, value);
 
     database = xcb_xrm_database_from_string(str_database);
+
+    /* The same lookup using a precompiled query must yield the same result. */
+    query = xcb_xrm_query_from_strings(res_name, res_class);
+    if (query != NULL) {
+        err |= check_get_resource_query(database, query, value);
+        err |= check_get_resource_search_list(database, res_name, res_class, value);
+
+        xcb_xrm_query_free(query);
+    }
+
     if (xcb_xrm_resource_get_string(database, res_name, res_class, &xcb_value) < 0) {
         if (value != NULL) {
             fprintf(stderr, "xcb_xrm_resource_get_string() returned NULL\n");
@@ -311,6 +650,73 @@ done_get_resource:
     return err;
 }
 
+static int check_get_resource_query(xcb_xrm_database_t *database, xcb_xrm_query_t *query, const char *value) {
+    bool err = false;
+    char *xcb_value;
+    const char *xcb_ref;
+
+    if (query == NULL) {
+        fprintf(stderr, "Failed to create query\n");
+        return true;
+    }
+
+    if (xcb_xrm_resource_get_string_query(database, query, &xcb_value) < 0) {
+        return check_strings(value, NULL, "Expected <%s>, but query returned NULL\n", value);
+    }
+
+    err |= check_strings(value, xcb_value, "Expected <%s>, but query returned <%s>\n", value, xcb_value);
+    free(xcb_value);
+
+    /* The borrowed value must be the same, but point into the database. */
+    if (xcb_xrm_resource_get_string_ref_query(database, query, &xcb_ref) < 0) {
+        return check_strings(value, NULL, "Expected <%s>, but query returned NULL reference\n", value);
+    }
+
+    err |= check_strings(value, xcb_ref, "Expected <%s>, but query returned reference <%s>\n", value, xcb_ref);
+    return err;
+}
+
+static int check_get_resource_search_list(xcb_xrm_database_t *database, const char *res_name, const char *res_class,
+        const char *value) {
+    bool err = false;
+    char *prefix_name = strdup(res_name);
+    char *prefix_class = (res_class == NULL || strlen(res_class) == 0) ? NULL : strdup(res_class);
+    char *name = strrchr(prefix_name, '.');
+    char *class = (prefix_class == NULL) ? NULL : strrchr(prefix_class, '.');
+    xcb_xrm_query_t *prefix = NULL;
+    xcb_xrm_query_t *query = NULL;
+    xcb_xrm_search_list_t *search_list = NULL;
+    const char *xcb_value;
+
+    /* Split the resource into the prefix and the last component and resolve
+     * the last component against a search list for the prefix. */
+    if (name != NULL) {
+        *(name++) = '\0';
+        if (class != NULL)
+            *(class++) = '\0';
+
+        prefix = xcb_xrm_query_from_strings(prefix_name, prefix_class);
+        query = xcb_xrm_query_from_strings(name, class);
+    } else {
+        query = xcb_xrm_query_from_strings(prefix_name, prefix_class);
+    }
+
+    search_list = xcb_xrm_search_list_new(database, prefix);
+    if (query != NULL && search_list != NULL && (name == NULL || prefix != NULL)) {
+        if (xcb_xrm_search_list_get_string_ref(search_list, query, &xcb_value) < 0)
+            xcb_value = NULL;
+
+        err |= check_strings(value, xcb_value, "Expected <%s>, but search list returned <%s>\n", value, xcb_value);
+    }
+
+    xcb_xrm_search_list_free(search_list);
+    xcb_xrm_query_free(prefix);
+    xcb_xrm_query_free(query);
+    free(prefix_name);
+    free(prefix_class);
+    return err;
+}
+
 static int check_convert_to_long(const char *value, const long expected, int expected_return_code) {
     char *db_str = NULL;
     long actual;
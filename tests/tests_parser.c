@@ -32,6 +32,7 @@
 
 /* We need this because to need to access non-public API. */
 #include "database.h"
+#include "query.h"
 #include "resource.h"
 
 /* Forward declarations */
@@ -93,6 +94,16 @@ int main(void) {
     err |= check_parse_entry_error("Först: 1", -1);
     err |= check_parse_entry_error("F~rst: 1", -1);
 
+    /* Names and values which are scanned in blocks. */
+    err |= check_parse_entry("abcdefghijklmnopqrstuvwxyz.ABCDEFGHIJKLMNOPQRSTUVWXYZ_-0123456789: 1", "1", "..", 2,
+            "abcdefghijklmnopqrstuvwxyz", "ABCDEFGHIJKLMNOPQRSTUVWXYZ_-0123456789");
+    err |= check_parse_entry("First*abcdefghijklmnopqrstuvwxyz0123456789.?.last: 1", "1", ".*..", 4,
+            "First", "abcdefghijklmnopqrstuvwxyz0123456789", "?", "last");
+    err |= check_parse_entry("First: abcdefghijklmnopqrstuvwxyz0123456789\\nabcdefghijklmnopqrstuvwxyz\\\\",
+            "abcdefghijklmnopqrstuvwxyz0123456789\nabcdefghijklmnopqrstuvwxyz\\", ".", 1, "First");
+    err |= check_parse_entry_error("abcdefghijklmnopqrstuvwxyz0123456789[: 1", -1);
+    err |= check_parse_entry_error("abcdefghijklmnopqrstuvwxyz0123456789\x80: 1", -1);
+
     /* Buffer size tests. Let's hope you don't have line wrapping enabled. */
     err |= check_parse_entry(
             "First: xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx",
@@ -120,13 +131,14 @@ static int check_parse_entry(const char *str, const char *value, const char *bin
     bool err = false;
     xcb_xrm_entry_t *entry;
     xcb_xrm_component_t *component;
-    int actual_length = 0;
+    xcb_xrm_query_t *query;
+    int actual_length;
     int i = 0;
     va_list ap;
 
     fprintf(stderr, "== Assert that parsing \"%s\" is successful\n", str);
 
-    if (xcb_xrm_entry_parse(str, &entry, check_parse_entry_resource_only) < 0) {
+    if (xcb_xrm_entry_parse(str, &entry, check_parse_entry_resource_only, NULL) < 0) {
         fprintf(stderr, "xcb_xrm_entry_parse() < 0\n");
         return true;
     }
@@ -139,23 +151,32 @@ static int check_parse_entry(const char *str, const char *value, const char *bin
     }
 
     /* Assert the number of components. */
-    TAILQ_FOREACH(component, &(entry->components), components) {
-        actual_length++;
-    }
+    actual_length = entry->num_components;
     err |= check_ints(count, actual_length, "Wrong number of components: <%d> / <%d>\n", count, actual_length);
 
     /* Assert the individual components. */
     va_start(ap, count);
-    TAILQ_FOREACH(component, &(entry->components), components) {
+    for (int j = 0; j < entry->num_components; j++) {
         const char *curr = va_arg(ap, const char *);
         char tmp[2] = "\0";
 
+        component = &(entry->components[j]);
         switch (component->type) {
             case CT_WILDCARD:
                 err |= check_strings("?", curr, "Expected '?', but got <%s>\n", curr);
                 break;
             case CT_NORMAL:
-                err |= check_strings(component->name, curr, "Expected <%s>, but got <%s>\n", component->name, curr);
+                /* Component names are interned, so compare them against the
+                 * name of a query for the expected component. */
+                query = xcb_xrm_query_from_strings(curr, NULL);
+                if (query == NULL || query->name->num_components != 1) {
+                    fprintf(stderr, "Failed to create a query for <%s>\n", curr);
+                    err = true;
+                } else if (query->name->components[0].name != component->name) {
+                    fprintf(stderr, "Expected <%s>, but got a different component\n", curr);
+                    err = true;
+                }
+                xcb_xrm_query_free(query);
                 break;
             default:
                 err = true;
@@ -187,7 +208,7 @@ static int check_parse_entry_error(const char *str, const int result) {
 
     fprintf(stderr, "== Assert that parsing \"%s\" returns <%d>\n", str, result);
 
-    actual = xcb_xrm_entry_parse(str, &entry, check_parse_entry_resource_only);
+    actual = xcb_xrm_entry_parse(str, &entry, check_parse_entry_resource_only, NULL);
     xcb_xrm_entry_free(entry);
     return check_ints(result, actual, "Wrong result code: <%d> / <%d>\n", result, actual);
 }